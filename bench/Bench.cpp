@@ -0,0 +1,391 @@
+#include "../src/AllocTracker.h"
+#include "../src/Config.h"
+#include "../src/PerfCounters.h"
+#include "../src/ShapeBatch.hpp"
+#include "../src/World.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Scenario benchmark: runs each scripted scenario headlessly for a fixed
+// number of ticks, reports wall time and ns/entity per system as JSON and
+// compares against a stored baseline. Profiling builds also report heap
+// allocations per tick for each stage, and --perf adds hardware counters per
+// entity (Linux perf_event_open; skipped with a note where not permitted).
+// Reading the counters costs two syscalls per stage, so --perf timings are
+// not comparable with the baseline.
+//
+// The scenarios run on bench/config.txt, not the game's config: a fixed seed
+// makes every run spawn the same enemies, and gameplay options are pinned
+// there so editing res/config.txt never moves the numbers. A change to
+// bench/config.txt needs the baseline re-recorded with it.
+//
+// usage: bench_runner [--config path] [--scenarios path] [--baseline path]
+//                     [--out path] [--threshold 0.15] [--min-ms 1.0]
+//                     [--perf] [--update-baseline]
+//
+// Stages whose baseline total is under --min-ms are too short to compare
+// reliably and are skipped.
+
+using Clock = std::chrono::steady_clock;
+
+struct Scenario
+{
+    std::string name;
+    int enemies = 0;
+    float bulletsPerTick = 0.f;
+    float splitsPerTick = 0.f;
+    int ticks = 0;
+    bool render = false;
+};
+
+struct StageResult
+{
+    double totalNs = 0.0;
+    double nsPerEntity = 0.0;
+    double allocsPerTick = -1.0;
+    double bytesPerTick = -1.0;
+    PerfSample counters;
+};
+
+struct ScenarioResult
+{
+    std::string name;
+    int ticks = 0;
+    double avgEntities = 0.0;
+    double wallMs = 0.0;
+    std::vector<std::pair<std::string, StageResult>> stages;
+};
+
+// name -> stage -> timings
+using Baseline = std::map<std::string, std::map<std::string, StageResult>>;
+
+static std::vector<Scenario> loadScenarios(const std::string &path)
+{
+    std::vector<Scenario> scenarios;
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: Could not open scenarios file " << path << "\n";
+        return scenarios;
+    }
+
+    std::string type;
+    while (file >> type)
+    {
+        if (type == "Scenario")
+        {
+            Scenario s;
+            int render = 0;
+            if (!(file >> s.name >> s.enemies >> s.bulletsPerTick >> s.splitsPerTick >> s.ticks >> render))
+            {
+                std::cerr << "Error: Malformed Scenario line in " << path << "\n";
+                return {};
+            }
+            s.render = render != 0;
+            scenarios.push_back(s);
+        }
+        else
+        {
+            // comments and anything unknown run to the end of the line
+            std::string discard;
+            std::getline(file, discard);
+        }
+    }
+    return scenarios;
+}
+
+static ScenarioResult runScenario(const Scenario &scenario, const GameConfig &config, const PerfCounters *perf)
+{
+    constexpr size_t stageCount = static_cast<size_t>(World::System::Count) + 1;
+    constexpr size_t renderStage = stageCount - 1;
+
+    World world;
+    world.init(config);
+    const float dt = 1.f / static_cast<float>(config.window.FPS);
+    const Vec2<float> bounds = world.bounds();
+
+    for (int i = 0; i < scenario.enemies; i++)
+    {
+        world.spawnEnemy();
+    }
+    world.entities().update();
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> rx(0.f, bounds.x);
+    std::uniform_real_distribution<float> ry(0.f, bounds.y);
+    ShapeBatch shapes;
+
+    std::vector<double> stageNs(stageCount, 0.0);
+    std::vector<double> stageAllocs(stageCount, 0.0);
+    std::vector<double> stageBytes(stageCount, 0.0);
+    std::vector<PerfSample> stageCounters(stageCount);
+    double entityTicks = 0.0;
+    float bulletDebt = 0.f;
+    float splitDebt = 0.f;
+
+    auto wallStart = Clock::now();
+    for (int tick = 0; tick < scenario.ticks; tick++)
+    {
+        // scripted load, applied like player input before the step
+        bulletDebt += scenario.bulletsPerTick;
+        for (; bulletDebt >= 1.f; bulletDebt -= 1.f)
+        {
+            world.spawnBullet(world.player(), Vec2<float>(rx(rng), ry(rng)));
+        }
+
+        splitDebt += scenario.splitsPerTick;
+        const auto &enemies = world.entities().getEntities("enemy");
+        for (size_t i = 0; splitDebt >= 1.f && i < enemies.size(); i++)
+        {
+            if (!enemies[i]->isAlive()) continue;
+            enemies[i]->destroy();
+            world.spawnSmallEnemies(enemies[i]);
+            world.spawnEnemy();
+            splitDebt -= 1.f;
+        }
+
+        entityTicks += static_cast<double>(world.entities().getEntities().size());
+
+        auto timed = [&](size_t stage, auto &&fn)
+        {
+#ifdef ARCHANGEL_PROFILE
+            AllocCounters before = AllocTracker::totals();
+#endif
+            PerfSample counters = perf ? perf->read() : PerfSample{};
+            auto start = Clock::now();
+            fn();
+            stageNs[stage] += std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+            if (perf) stageCounters[stage] += perf->read() - counters;
+#ifdef ARCHANGEL_PROFILE
+            stageAllocs[stage] += static_cast<double>(AllocTracker::totals().count - before.count);
+            stageBytes[stage] += static_cast<double>(AllocTracker::totals().bytes - before.bytes);
+#endif
+        };
+
+        world.step(dt, [&](World::System system, auto &&fn)
+        {
+            timed(static_cast<size_t>(system), fn);
+        });
+
+        if (scenario.render)
+        {
+            timed(renderStage, [&]
+            {
+                shapes.build(world.entities().getEntities());
+                world.particles().buildVertices();
+            });
+        }
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(Clock::now() - wallStart).count();
+
+    ScenarioResult result;
+    result.name = scenario.name;
+    result.ticks = scenario.ticks;
+    result.avgEntities = scenario.ticks > 0 ? entityTicks / scenario.ticks : 0.0;
+    result.wallMs = wallMs;
+    for (size_t i = 0; i < stageCount; i++)
+    {
+        if (i == renderStage && !scenario.render) continue;
+
+        StageResult stage;
+        stage.totalNs = stageNs[i];
+        stage.nsPerEntity = entityTicks > 0.0 ? stageNs[i] / entityTicks : 0.0;
+        stage.counters = stageCounters[i];
+#ifdef ARCHANGEL_PROFILE
+        stage.allocsPerTick = stageAllocs[i] / scenario.ticks;
+        stage.bytesPerTick = stageBytes[i] / scenario.ticks;
+#endif
+        std::string name = i == renderStage ? "render_vertices" : World::systemName(static_cast<World::System>(i));
+        result.stages.emplace_back(name, stage);
+    }
+    return result;
+}
+
+static std::string toJson(const std::vector<ScenarioResult> &results, const PerfCounters *perf)
+{
+    // one stage per line; readBaseline depends on that layout
+    std::ostringstream out;
+    out << "{\n  \"scenarios\": [\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const auto &r = results[i];
+        out << "    {\n";
+        out << "      \"name\": \"" << r.name << "\",\n";
+        out << "      \"ticks\": " << r.ticks << ",\n";
+        out << "      \"avg_entities\": " << r.avgEntities << ",\n";
+        out << "      \"wall_ms\": " << r.wallMs << ",\n";
+        out << "      \"systems\": {\n";
+        for (size_t j = 0; j < r.stages.size(); j++)
+        {
+            const auto &[name, s] = r.stages[j];
+            out << "        \"" << name << "\": {\"total_ms\": " << s.totalNs / 1e6
+                << ", \"ns_per_entity\": " << s.nsPerEntity;
+            if (s.allocsPerTick >= 0.0)
+            {
+                out << ", \"allocs_per_tick\": " << s.allocsPerTick << ", \"bytes_per_tick\": " << s.bytesPerTick;
+            }
+            if (perf)
+            {
+                double entityTicks = r.avgEntities * r.ticks;
+                out << ", \"counters_per_entity\": {";
+                bool first = true;
+                for (int c = 0; c < PerfCounters::Count; c++)
+                {
+                    auto counter = static_cast<PerfCounters::Counter>(c);
+                    if (!perf->has(counter)) continue;
+                    double value = entityTicks > 0.0 ? static_cast<double>(s.counters.counts[c]) / entityTicks : 0.0;
+                    out << (first ? "" : ", ") << "\"" << PerfCounters::name(counter) << "\": " << value;
+                    first = false;
+                }
+                out << "}";
+            }
+            out << "}"
+                << (j + 1 < r.stages.size() ? "," : "") << "\n";
+        }
+        out << "      }\n";
+        out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+// Reads back files written by toJson; not a general JSON parser.
+static Baseline readBaseline(const std::string &path)
+{
+    Baseline baseline;
+    std::ifstream file(path);
+    std::string line;
+    std::string scenario;
+
+    auto quoted = [](const std::string &s, size_t from)
+    {
+        size_t a = s.find('"', from);
+        size_t b = s.find('"', a + 1);
+        return (a == std::string::npos || b == std::string::npos) ? std::string() : s.substr(a + 1, b - a - 1);
+    };
+
+    while (std::getline(file, line))
+    {
+        if (line.find("\"name\":") != std::string::npos)
+        {
+            scenario = quoted(line, line.find(':'));
+        }
+        else if (size_t at = line.find("\"ns_per_entity\":"); at != std::string::npos)
+        {
+            auto &stage = baseline[scenario][quoted(line, 0)];
+            stage.totalNs = std::atof(line.c_str() + line.find(':', line.find("\"total_ms\":")) + 1) * 1e6;
+            stage.nsPerEntity = std::atof(line.c_str() + line.find(':', at) + 1);
+        }
+    }
+    return baseline;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string configPath = "bench/config.txt";
+    std::string scenariosPath = "bench/scenarios.txt";
+    std::string baselinePath = "bench/baseline.json";
+    std::string outPath = "bench_results.json";
+    double threshold = 0.15;
+    double minMs = 1.0;
+    bool updateBaseline = false;
+    bool usePerf = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--config" && hasValue) configPath = argv[++i];
+        else if (arg == "--scenarios" && hasValue) scenariosPath = argv[++i];
+        else if (arg == "--baseline" && hasValue) baselinePath = argv[++i];
+        else if (arg == "--out" && hasValue) outPath = argv[++i];
+        else if (arg == "--threshold" && hasValue) threshold = std::atof(argv[++i]);
+        else if (arg == "--min-ms" && hasValue) minMs = std::atof(argv[++i]);
+        else if (arg == "--perf") usePerf = true;
+        else if (arg == "--update-baseline") updateBaseline = true;
+        else
+        {
+            std::cerr << "Error: Unknown argument '" << arg << "'\n";
+            return 2;
+        }
+    }
+
+    GameConfig config;
+    if (!loadConfig(configPath, config))
+    {
+        return 2;
+    }
+
+    std::vector<Scenario> scenarios = loadScenarios(scenariosPath);
+    if (scenarios.empty())
+    {
+        return 2;
+    }
+
+    PerfCounters perf;
+    if (usePerf && !perf.open())
+    {
+        std::cerr << "note: hardware counters disabled: " << perf.error() << "\n";
+    }
+    const PerfCounters *counters = perf.available() ? &perf : nullptr;
+
+    std::vector<ScenarioResult> results;
+    for (const auto &s : scenarios)
+    {
+        std::cout << "running " << s.name << " (" << s.enemies << " enemies, " << s.ticks << " ticks)\n";
+        results.push_back(runScenario(s, config, counters));
+    }
+
+    std::string json = toJson(results, counters);
+    std::ofstream(outPath) << json;
+    std::cout << json;
+
+    if (updateBaseline)
+    {
+        std::ofstream(baselinePath) << json;
+        std::cout << "baseline written to " << baselinePath << "\n";
+        return 0;
+    }
+
+    Baseline baseline = readBaseline(baselinePath);
+    if (baseline.empty())
+    {
+        std::cout << "no baseline at " << baselinePath << ", skipping comparison\n";
+        return 0;
+    }
+
+    int regressions = 0;
+    for (const auto &r : results)
+    {
+        auto scenarioIt = baseline.find(r.name);
+        if (scenarioIt == baseline.end()) continue;
+
+        for (const auto &[name, stage] : r.stages)
+        {
+            auto stageIt = scenarioIt->second.find(name);
+            if (stageIt == scenarioIt->second.end()) continue;
+
+            const StageResult &base = stageIt->second;
+            if (base.totalNs < minMs * 1e6 || base.nsPerEntity <= 0.0) continue;
+
+            double change = stage.nsPerEntity / base.nsPerEntity - 1.0;
+            if (change > threshold)
+            {
+                std::cout << "REGRESSION " << r.name << "/" << name << ": " << base.nsPerEntity << " -> "
+                          << stage.nsPerEntity << " ns/entity (+" << change * 100.0 << "%)\n";
+                regressions++;
+            }
+        }
+    }
+
+    std::cout << regressions << " regression(s) over " << threshold * 100.0 << "% threshold\n";
+    return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,529 @@
+#include "MicroBench.hpp"
+
+#include "../src/CollisionQuery.h"
+#include "../src/ContactSolver.h"
+#include "../src/EntityManager.hpp"
+#include "../src/FlowField.h"
+#include "../src/Observation.h"
+#include "../src/PolygonCollider.h"
+#include "../src/Random.hpp"
+#include "../src/Vec2.hpp"
+#include "../src/World.h"
+#include "../src/WorldFile.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+// Microbenchmarks for the pieces everything else is built from.
+// usage: micro_runner [filter] [min seconds per case]
+
+void *operator new(std::size_t size)
+{
+    micro::allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+static std::vector<Vec2<float>> randomVecs(size_t n)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> d(-100.f, 100.f);
+    std::vector<Vec2<float>> v(n);
+    for (auto &p : v)
+    {
+        p = Vec2<float>(d(rng), d(rng));
+    }
+    return v;
+}
+
+// Fills a manager with n entities spread over the game's four tags.
+static void populate(EntityManager &em, size_t n)
+{
+    static const char *tags[] = {"enemy", "smallEnemy", "bullet", "player"};
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> pos(0.f, 1000.f);
+    for (size_t i = 0; i < n; i++)
+    {
+        auto e = em.addEntity(tags[i % 4]);
+        e->add<CTransform>(Vec2<float>(pos(rng), pos(rng)), Vec2<float>(1.f, 1.f), 0.f, 0.f);
+        e->add<CCollision>(8.f);
+        if (i % 3 == 0)
+        {
+            e->add<CLifespan>(60);
+        }
+    }
+    em.update();
+}
+
+static void Vec2Arithmetic(micro::State &state)
+{
+    auto a = randomVecs(static_cast<size_t>(state.arg()));
+    auto b = randomVecs(static_cast<size_t>(state.arg()));
+    state.setItemsPerIteration(a.size());
+    while (state.next())
+    {
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            a[i] += (b[i] - a[i]) * 0.5f + b[i] / 4.f;
+        }
+        micro::doNotOptimize(a);
+    }
+}
+MICRO_BENCH(Vec2Arithmetic, 1024, 65536);
+
+static void Vec2Normalize(micro::State &state)
+{
+    auto src = randomVecs(static_cast<size_t>(state.arg()));
+    auto v = src;
+    state.setItemsPerIteration(v.size());
+    while (state.next())
+    {
+        for (auto &p : v)
+        {
+            p.normalize();
+            p *= 3.f;
+        }
+        micro::doNotOptimize(v);
+    }
+}
+MICRO_BENCH(Vec2Normalize, 1024, 65536);
+
+static void Vec2Dist(micro::State &state)
+{
+    auto a = randomVecs(static_cast<size_t>(state.arg()));
+    auto b = randomVecs(static_cast<size_t>(state.arg()));
+    state.setItemsPerIteration(a.size());
+    while (state.next())
+    {
+        float sum = 0.f;
+        for (size_t i = 0; i < a.size(); i++)
+        {
+            sum += a[i].dist(b[i]);
+        }
+        micro::doNotOptimize(sum);
+    }
+}
+MICRO_BENCH(Vec2Dist, 1024, 65536);
+
+// Add n entities, apply, destroy them all and apply again.
+static void EntityChurn(micro::State &state)
+{
+    EntityManager em;
+    const size_t n = static_cast<size_t>(state.arg());
+    state.setItemsPerIteration(n);
+    while (state.next())
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            auto e = em.addEntity(i % 2 ? "bullet" : "smallEnemy");
+            e->add<CTransform>();
+            e->add<CLifespan>(10);
+        }
+        em.update();
+        for (auto &e : em.getEntities())
+        {
+            e->destroy();
+        }
+        em.update();
+    }
+}
+MICRO_BENCH(EntityChurn, 100, 1000, 10000);
+
+// EntityChurn through reserved pools, the way bullets and small enemies spawn.
+static void PooledChurn(micro::State &state)
+{
+    EntityManager em;
+    const size_t n = static_cast<size_t>(state.arg());
+    const size_t pools[] = {em.reserve("smallEnemy", n / 2), em.reserve("bullet", n / 2)};
+    state.setItemsPerIteration(n);
+    while (state.next())
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            auto e = em.addPooled(pools[i % 2]);
+            e->add<CTransform>();
+            e->add<CLifespan>(10);
+        }
+        em.update();
+        for (auto &e : em.getEntities())
+        {
+            e->destroy();
+        }
+        em.update();
+    }
+}
+MICRO_BENCH(PooledChurn, 100, 1000, 10000);
+
+static void GetEntitiesByTag(micro::State &state)
+{
+    EntityManager em;
+    populate(em, static_cast<size_t>(state.arg()));
+    state.setItemsPerIteration(4);
+    while (state.next())
+    {
+        size_t total = em.getEntities("enemy").size() + em.getEntities("bullet").size() +
+                       em.getEntities("smallEnemy").size() + em.getEntities("player").size();
+        micro::doNotOptimize(total);
+    }
+}
+MICRO_BENCH(GetEntitiesByTag, 100, 100000);
+
+static void EntityHasGet(micro::State &state)
+{
+    EntityManager em;
+    populate(em, static_cast<size_t>(state.arg()));
+    const auto &entities = em.getEntities();
+    state.setItemsPerIteration(entities.size());
+    while (state.next())
+    {
+        int sum = 0;
+        for (auto &e : entities)
+        {
+            if (e->has<CLifespan>())
+            {
+                sum += e->get<CLifespan>().remaining;
+            }
+        }
+        micro::doNotOptimize(sum);
+    }
+}
+MICRO_BENCH(EntityHasGet, 1000, 10000, 100000);
+
+// Every bullet against every enemy, the shape of sCollision's inner loop.
+static void IsCollidingPairs(micro::State &state)
+{
+    World world;
+    EntityManager &em = world.entities();
+    populate(em, static_cast<size_t>(state.arg()));
+    const auto &a = em.getEntities("bullet");
+    const auto &b = em.getEntities("enemy");
+    state.setItemsPerIteration(a.size() * b.size());
+    while (state.next())
+    {
+        size_t hits = 0;
+        for (auto &x : a)
+        {
+            for (auto &y : b)
+            {
+                hits += world.isColliding(x, y);
+            }
+        }
+        micro::doNotOptimize(hits);
+    }
+}
+MICRO_BENCH(IsCollidingPairs, 100, 1000, 4000);
+
+// The polygon test alone, per pair, on pairs that all overlap as circles:
+// the cost World::isColliding adds to every circle hit. Enemy polygons of
+// 3 to 8 points against arg-point enemies, or against bullet-sized circles
+// once arg is past PolygonCollider::MAX_POINTS.
+static void PolygonOverlap(micro::State &state)
+{
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+    const auto points = static_cast<size_t>(state.arg());
+    const float otherRadius = points > PolygonCollider::MAX_POINTS ? 10.f : 32.f;
+    std::vector<CShape> shapes;
+    std::vector<CTransform> transforms;
+    for (size_t i = 0; i < 1024; i++)
+    {
+        shapes.emplace_back(32.f, 3 + i % 6, sf::Color::White, sf::Color::White, 0.f);
+        shapes.emplace_back(otherRadius, points, sf::Color::White, sf::Color::White, 0.f);
+
+        const float dir = unit(rng) * 6.2831853f;
+        const float dist = unit(rng) * (32.f + otherRadius);
+        transforms.emplace_back(Vec2<float>(0.f, 0.f), Vec2<float>(0.f, 0.f), unit(rng) * 360.f, 0.f);
+        transforms.emplace_back(Vec2<float>(std::cos(dir) * dist, std::sin(dir) * dist), Vec2<float>(0.f, 0.f),
+                                unit(rng) * 360.f, 0.f);
+    }
+
+    state.setItemsPerIteration(shapes.size() / 2);
+    while (state.next())
+    {
+        size_t hits = 0;
+        for (size_t i = 0; i < shapes.size(); i += 2)
+        {
+            hits += PolygonCollider::overlaps(shapes[i], transforms[i], shapes[i + 1], transforms[i + 1]);
+        }
+        micro::doNotOptimize(hits);
+    }
+}
+MICRO_BENCH(PolygonOverlap, 3, 8, 20);
+
+// Loading a world dump of n entities from memory, compressed and raw.
+static void worldFileLoad(micro::State &state, bool compress)
+{
+    World source;
+    populate(source.entities(), static_cast<size_t>(state.arg()));
+    std::vector<std::uint8_t> file;
+    WorldFile::write(file, source, compress);
+
+    World world;
+    state.setItemsPerIteration(static_cast<size_t>(state.arg()));
+    while (state.next())
+    {
+        bool ok = WorldFile::read(file.data(), file.size(), world);
+        micro::doNotOptimize(ok);
+    }
+}
+
+static void WorldFileLoad(micro::State &state)
+{
+    worldFileLoad(state, true);
+}
+MICRO_BENCH(WorldFileLoad, 1000, 100000);
+
+static void WorldFileLoadRaw(micro::State &state)
+{
+    worldFileLoad(state, false);
+}
+MICRO_BENCH(WorldFileLoadRaw, 1000, 100000);
+
+// One serial contact solve over the enemies and small enemies of n entities
+// on a 1000x1000 field, per body. Bodies keep the separation earlier
+// iterations gave them, so this is the steady state rather than the first
+// solve of a pile-up.
+static void ContactSolve(micro::State &state)
+{
+    World world;
+    EntityManager &em = world.entities();
+    populate(em, static_cast<size_t>(state.arg()));
+    PhysicsConfig config;
+    config.ENABLED = 1;
+    ContactSolver solver;
+    const auto &enemies = em.getEntities("enemy");
+    const auto &small = em.getEntities("smallEnemy");
+    state.setItemsPerIteration(enemies.size() + small.size());
+    while (state.next())
+    {
+        solver.solve({&enemies, &small}, config, Vec2<float>(1000.f, 1000.f), nullptr);
+        std::uint64_t contacts = solver.contacts();
+        micro::doNotOptimize(contacts);
+    }
+}
+MICRO_BENCH(ContactSolve, 1000, 10000, 40000);
+
+// Full-length rays across a 1000x1000 field of n entities, per ray: the
+// grid walk against testing every enemy, which is what the laser would do
+// without it. Every hit is collected, as the laser does.
+static std::vector<Ray> randomRays(size_t n)
+{
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> pos(0.f, 1000.f);
+    std::uniform_real_distribution<float> angle(0.f, 6.2831853f);
+    std::vector<Ray> rays(n);
+    for (auto &r : rays)
+    {
+        const float a = angle(rng);
+        r = Ray{Vec2<float>(pos(rng), pos(rng)), Vec2<float>(std::cos(a), std::sin(a)), 1415.f, 4.f};
+    }
+    return rays;
+}
+
+static void Raycast(micro::State &state)
+{
+    World world;
+    EntityManager &em = world.entities();
+    populate(em, static_cast<size_t>(state.arg()));
+    CollisionQuery query;
+    query.build({&em.getEntities("enemy"), &em.getEntities("smallEnemy")}, Vec2<float>(1000.f, 1000.f));
+    const auto rays = randomRays(256);
+    std::vector<RayHit> hits;
+    state.setItemsPerIteration(rays.size());
+    while (state.next())
+    {
+        size_t total = 0;
+        for (const Ray &ray : rays)
+        {
+            query.raycast(ray, hits);
+            total += hits.size();
+        }
+        micro::doNotOptimize(total);
+    }
+}
+MICRO_BENCH(Raycast, 1000, 10000, 100000);
+
+static void RaycastAll(micro::State &state)
+{
+    World world;
+    EntityManager &em = world.entities();
+    populate(em, static_cast<size_t>(state.arg()));
+    const auto rays = randomRays(256);
+    state.setItemsPerIteration(rays.size());
+    while (state.next())
+    {
+        size_t total = 0;
+        for (const Ray &ray : rays)
+        {
+            for (const char *tag : {"enemy", "smallEnemy"})
+            {
+                for (Entity *e : em.getEntities(tag))
+                {
+                    const Vec2<float> f = e->get<CTransform>().pos - ray.origin;
+                    const float along = f.x * ray.dir.x + f.y * ray.dir.y;
+                    const float r = e->get<CCollision>().radius + ray.radius;
+                    const float off2 = f.x * f.x + f.y * f.y - along * along;
+                    total += off2 <= r * r && along + r >= 0.f && along - r <= ray.length;
+                }
+            }
+        }
+        micro::doNotOptimize(total);
+    }
+}
+MICRO_BENCH(RaycastAll, 1000, 10000, 100000);
+
+// Building the query over the 50k enemies of 100000 entities, per entity;
+// the shockwave pays this once per shot on top of its circle query.
+static void CollisionQueryBuild(micro::State &state)
+{
+    World world;
+    EntityManager &em = world.entities();
+    populate(em, static_cast<size_t>(state.arg()));
+    CollisionQuery query;
+    state.setItemsPerIteration(static_cast<size_t>(state.arg()) / 2);
+    while (state.next())
+    {
+        query.build({&em.getEntities("enemy"), &em.getEntities("smallEnemy")}, Vec2<float>(1000.f, 1000.f));
+        micro::doNotOptimize(query);
+    }
+}
+MICRO_BENCH(CollisionQueryBuild, 10000, 100000);
+
+// A circle of arg radius at the middle of the same 50k enemies, per query;
+// 800 covers the whole field.
+static void QueryCircle(micro::State &state)
+{
+    World world;
+    EntityManager &em = world.entities();
+    populate(em, 100000);
+    CollisionQuery query;
+    query.build({&em.getEntities("enemy"), &em.getEntities("smallEnemy")}, Vec2<float>(1000.f, 1000.f));
+    std::vector<Entity *> out(query.size());
+    const float radius = static_cast<float>(state.arg());
+    while (state.next())
+    {
+        size_t n = query.queryCircle(Vec2<float>(500.f, 500.f), radius, 3, out);
+        micro::doNotOptimize(n);
+    }
+}
+MICRO_BENCH(QueryCircle, 50, 200, 800);
+
+// Rebuilding the field over the default 1280x720 world with arg-pixel
+// cells, per cell; happens whenever the player changes cell.
+static void FlowFieldBuild(micro::State &state)
+{
+    FlowField field;
+    field.resize(Vec2<float>(1280.f, 720.f), static_cast<int>(state.arg()));
+    state.setItemsPerIteration(static_cast<size_t>(field.width() * field.height()));
+    float x = 0.f;
+    while (state.next())
+    {
+        // a new cell each time, so every update rebuilds
+        x = x + static_cast<float>(state.arg()) >= 1280.f ? 0.f : x + static_cast<float>(state.arg());
+        field.update(Vec2<float>(x, 360.f));
+    }
+}
+MICRO_BENCH(FlowFieldBuild, 40, 10);
+
+// Observations of a world of n entities, per entity.
+static void ObserveGrid(micro::State &state)
+{
+    World world;
+    populate(world.entities(), static_cast<size_t>(state.arg()));
+    ObservationGrid grid;
+    std::vector<float> out(grid.size());
+    state.setItemsPerIteration(static_cast<size_t>(state.arg()));
+    while (state.next())
+    {
+        grid.write(world, out);
+        micro::doNotOptimize(out);
+    }
+}
+MICRO_BENCH(ObserveGrid, 100, 1000, 10000);
+
+static void ObserveNearest(micro::State &state)
+{
+    World world;
+    populate(world.entities(), static_cast<size_t>(state.arg()));
+    ObservationNearest nearest;
+    std::vector<float> out(nearest.size());
+    state.setItemsPerIteration(static_cast<size_t>(state.arg()));
+    while (state.next())
+    {
+        nearest.write(world, out);
+        micro::doNotOptimize(out);
+    }
+}
+MICRO_BENCH(ObserveNearest, 100, 1000, 10000);
+
+// One float in [min, max) per item: the old per-call distribution over
+// mt19937 against Rng::uniform and the batched Rng::fillUniform.
+static void RandomMt19937(micro::State &state)
+{
+    std::mt19937 rng(42);
+    std::vector<float> out(static_cast<size_t>(state.arg()));
+    state.setItemsPerIteration(out.size());
+    while (state.next())
+    {
+        for (auto &v : out)
+        {
+            std::uniform_real_distribution<float> d(-1.f, 1.f);
+            v = d(rng);
+        }
+        micro::doNotOptimize(out);
+    }
+}
+MICRO_BENCH(RandomMt19937, 1024);
+
+static void RandomUniform(micro::State &state)
+{
+    Rng rng(42);
+    std::vector<float> out(static_cast<size_t>(state.arg()));
+    state.setItemsPerIteration(out.size());
+    while (state.next())
+    {
+        for (auto &v : out)
+        {
+            v = rng.uniform(-1.f, 1.f);
+        }
+        micro::doNotOptimize(out);
+    }
+}
+MICRO_BENCH(RandomUniform, 1024);
+
+static void RandomFillUniform(micro::State &state)
+{
+    Rng rng(42);
+    std::vector<float> out(static_cast<size_t>(state.arg()));
+    state.setItemsPerIteration(out.size());
+    while (state.next())
+    {
+        rng.fillUniform(out, -1.f, 1.f);
+        micro::doNotOptimize(out);
+    }
+}
+MICRO_BENCH(RandomFillUniform, 1024);
+
+int main(int argc, char *argv[])
+{
+    std::string filter = argc > 1 ? argv[1] : "";
+    double minTime = argc > 2 ? std::atof(argv[2]) : 0.25;
+    return micro::runAll(filter, minTime);
+}
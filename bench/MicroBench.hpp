@@ -0,0 +1,197 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// A small Google-Benchmark-style harness with no dependencies. Cases register
+// with MICRO_BENCH(fn, args...) and loop on state.next(); the runner grows
+// the iteration count until a case runs for at least minTime and then
+// reports time, throughput, heap allocations and cycles per item.
+namespace micro
+{
+
+// Incremented by the operator new replacement in the benchmark executable.
+inline std::atomic<std::uint64_t> allocations{0};
+
+// Cycle counter where the CPU exposes one to user space. On arm64 this is
+// the generic timer, which ticks slower than the core clock.
+inline std::uint64_t readCycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    std::uint64_t v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+template <typename T>
+inline void doNotOptimize(T &value)
+{
+    asm volatile("" : "+m"(value) : : "memory");
+}
+
+class State
+{
+    std::uint64_t m_iterations;
+    std::uint64_t m_done = 0;
+    std::int64_t m_arg;
+    std::uint64_t m_items = 1;
+
+    std::chrono::steady_clock::time_point m_start;
+    std::chrono::steady_clock::duration m_elapsed{};
+    std::uint64_t m_cyclesStart = 0;
+    std::uint64_t m_cycles = 0;
+    std::uint64_t m_allocsStart = 0;
+    std::uint64_t m_allocs = 0;
+    bool m_running = false;
+
+    void start()
+    {
+        m_running = true;
+        m_allocsStart = allocations.load(std::memory_order_relaxed);
+        m_cyclesStart = readCycles();
+        m_start = std::chrono::steady_clock::now();
+    }
+
+    void stop()
+    {
+        m_elapsed += std::chrono::steady_clock::now() - m_start;
+        m_cycles += readCycles() - m_cyclesStart;
+        m_allocs += allocations.load(std::memory_order_relaxed) - m_allocsStart;
+        m_running = false;
+    }
+
+  public:
+    State(std::uint64_t iterations, std::int64_t arg)
+        : m_iterations(iterations), m_arg(arg) {}
+
+    // Loop condition for the measured body; the clock starts on the first
+    // call and stops once every iteration has run.
+    bool next()
+    {
+        if (!m_running && m_done == 0)
+        {
+            start();
+        }
+        if (m_done < m_iterations)
+        {
+            m_done++;
+            return true;
+        }
+        stop();
+        return false;
+    }
+
+    // Excludes setup or teardown inside the loop from the measurement.
+    void pause()
+    {
+        stop();
+    }
+
+    void resume()
+    {
+        start();
+    }
+
+    std::int64_t arg() const
+    {
+        return m_arg;
+    }
+
+    // Number of operations each iteration performs; throughput and
+    // cycles/op are reported per item.
+    void setItemsPerIteration(std::uint64_t items)
+    {
+        m_items = items;
+    }
+
+    std::uint64_t iterations() const { return m_iterations; }
+    std::uint64_t items() const { return m_items; }
+    double seconds() const { return std::chrono::duration<double>(m_elapsed).count(); }
+    std::uint64_t cycles() const { return m_cycles; }
+    std::uint64_t allocs() const { return m_allocs; }
+};
+
+struct Case
+{
+    std::string name;
+    std::function<void(State &)> fn;
+    std::int64_t arg;
+};
+
+inline std::vector<Case> &registry()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+struct Registrar
+{
+    Registrar(const char *name, void (*fn)(State &), std::vector<std::int64_t> args)
+    {
+        if (args.empty())
+        {
+            registry().push_back({name, fn, 0});
+        }
+        for (auto a : args)
+        {
+            registry().push_back({std::string(name) + "/" + std::to_string(a), fn, a});
+        }
+    }
+};
+
+// Runs every registered case whose name contains filter.
+inline int runAll(const std::string &filter, double minTime)
+{
+    std::printf("%-36s %12s %12s %14s %12s %12s\n", "case", "iterations", "ns/iter", "items/s", "allocs/iter", "cycles/item");
+    for (auto &c : registry())
+    {
+        if (!filter.empty() && c.name.find(filter) == std::string::npos) continue;
+
+        std::uint64_t iterations = 1;
+        for (;;)
+        {
+            State state(iterations, c.arg);
+            c.fn(state);
+
+            if (state.seconds() >= minTime || iterations >= (1ull << 40))
+            {
+                double n = static_cast<double>(state.iterations());
+                double items = n * static_cast<double>(state.items());
+                std::printf("%-36s %12llu %12.1f %14.4g %12.2f %12.2f\n", c.name.c_str(),
+                            static_cast<unsigned long long>(state.iterations()),
+                            state.seconds() * 1e9 / n,
+                            items / state.seconds(),
+                            static_cast<double>(state.allocs()) / n,
+                            static_cast<double>(state.cycles()) / items);
+                break;
+            }
+
+            // aim a little past minTime from what this round took
+            double scale = state.seconds() > 0.0 ? minTime * 1.4 / state.seconds() : 10.0;
+            iterations = static_cast<std::uint64_t>(static_cast<double>(iterations) * std::min(std::max(scale, 2.0), 100.0));
+        }
+    }
+    return 0;
+}
+
+} // namespace micro
+
+#define MICRO_CONCAT_(a, b) a##b
+#define MICRO_CONCAT(a, b) MICRO_CONCAT_(a, b)
+#define MICRO_BENCH(fn, ...) \
+    static micro::Registrar MICRO_CONCAT(micro_registrar_, __LINE__)(#fn, fn, {__VA_ARGS__})
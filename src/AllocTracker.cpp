@@ -0,0 +1,71 @@
+#include "AllocTracker.h"
+
+#ifdef ARCHANGEL_PROFILE
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+static void track(std::size_t size)
+{
+    AllocTracker::t_totals.count++;
+    AllocTracker::t_totals.bytes += size;
+
+    if (AllocTracker::t_noAllocDepth > 0)
+    {
+        AllocTracker::s_violations.fetch_add(1, std::memory_order_relaxed);
+        AllocTracker::s_lastViolation.store(AllocTracker::t_noAllocScope, std::memory_order_relaxed);
+#ifdef ARCHANGEL_ALLOC_ASSERT
+        std::fprintf(stderr, "Error: %zu byte allocation inside no-alloc scope '%s'\n", size,
+                     AllocTracker::t_noAllocScope);
+        std::abort();
+#endif
+    }
+}
+
+void *operator new(std::size_t size)
+{
+    track(size);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    track(size);
+    std::size_t a = static_cast<std::size_t>(align);
+    if (void *p = std::aligned_alloc(a, (size + a - 1) / a * a))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p) AllocTracker::t_totals.frees++;
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    if (p) AllocTracker::t_totals.frees++;
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept
+{
+    if (p) AllocTracker::t_totals.frees++;
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept
+{
+    if (p) AllocTracker::t_totals.frees++;
+    std::free(p);
+}
+
+#endif
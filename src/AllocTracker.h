@@ -0,0 +1,81 @@
+#pragma once
+
+// Heap allocation tracking. AllocTracker.cpp replaces the global operator
+// new/delete and counts every allocation against the calling thread. Profiler
+// zones snapshot those counts, so each zone reports the allocations made
+// inside it, and NO_ALLOC_SCOPE marks code that must not allocate at all.
+// With -DARCHANGEL_ALLOC_ASSERT (make ALLOC_ASSERT=1) an allocation inside a
+// no-alloc scope prints the scope and aborts; otherwise it is counted.
+//
+// Part of the ARCHANGEL_PROFILE instrumentation build.
+
+#ifdef ARCHANGEL_PROFILE
+
+#include <atomic>
+#include <cstdint>
+
+struct AllocCounters
+{
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t frees = 0;
+};
+
+class AllocTracker
+{
+  public:
+    static inline thread_local AllocCounters t_totals;
+    static inline thread_local const char *t_noAllocScope = nullptr;
+    static inline thread_local std::uint32_t t_noAllocDepth = 0;
+
+    static inline std::atomic<std::uint64_t> s_violations{0};
+    static inline std::atomic<const char *> s_lastViolation{nullptr};
+
+    // Running totals for the calling thread.
+    static const AllocCounters &totals()
+    {
+        return t_totals;
+    }
+
+    static std::uint64_t violations()
+    {
+        return s_violations.load(std::memory_order_relaxed);
+    }
+
+    static const char *lastViolation()
+    {
+        return s_lastViolation.load(std::memory_order_relaxed);
+    }
+};
+
+class NoAllocScope
+{
+    const char *m_previous;
+
+  public:
+    explicit NoAllocScope(const char *name)
+        : m_previous(AllocTracker::t_noAllocScope)
+    {
+        AllocTracker::t_noAllocScope = name;
+        AllocTracker::t_noAllocDepth++;
+    }
+
+    ~NoAllocScope()
+    {
+        AllocTracker::t_noAllocDepth--;
+        AllocTracker::t_noAllocScope = m_previous;
+    }
+
+    NoAllocScope(const NoAllocScope &) = delete;
+    NoAllocScope &operator=(const NoAllocScope &) = delete;
+};
+
+#define NO_ALLOC_CONCAT_(a, b) a##b
+#define NO_ALLOC_CONCAT(a, b) NO_ALLOC_CONCAT_(a, b)
+#define NO_ALLOC_SCOPE(name) NoAllocScope NO_ALLOC_CONCAT(noAllocScope_, __LINE__)(name)
+
+#else
+
+#define NO_ALLOC_SCOPE(name)
+
+#endif
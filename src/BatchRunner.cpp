@@ -0,0 +1,132 @@
+#include "Config.h"
+#include "Random.hpp"
+#include "WorldBatch.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Steps a WorldBatch with random actions and reports throughput in world
+// ticks per second.
+// usage: batch_runner [config] [--worlds n] [--threads n] [--ticks n] [--episode n] [--observe]
+//                     [--scaling]
+// --ticks is batch steps per run and --episode caps episode length.
+// --observe also writes a 64x36 grid and a nearest-16 observation of every
+// world after each step and reports what they cost. With
+// --scaling the same batch is run with 1, 2, 4, ... threads up to --threads
+// (default: every hardware thread) and each run's speedup over one thread is
+// printed.
+int main(int argc, char *argv[])
+{
+    std::string configPath = "res/config.txt";
+    long worlds = 256;
+    long maxThreads = 0;
+    long ticks = 600;
+    long episode = 3600;
+    bool scaling = false;
+    bool observe = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--worlds" && hasValue) worlds = std::atol(argv[++i]);
+        else if (arg == "--threads" && hasValue) maxThreads = std::atol(argv[++i]);
+        else if (arg == "--ticks" && hasValue) ticks = std::atol(argv[++i]);
+        else if (arg == "--episode" && hasValue) episode = std::atol(argv[++i]);
+        else if (arg == "--scaling") scaling = true;
+        else if (arg == "--observe") observe = true;
+        else if (arg.rfind("--", 0) != 0) configPath = arg;
+        else
+        {
+            std::cerr << "usage: batch_runner [config] [--worlds n] [--threads n] [--ticks n] [--episode n] "
+                         "[--observe] [--scaling]\n";
+            return 2;
+        }
+    }
+
+    GameConfig config;
+    if (!loadConfig(configPath, config))
+    {
+        return 1;
+    }
+    if (maxThreads <= 0) maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::vector<long> threadCounts;
+    for (long t = scaling ? 1 : maxThreads; t < maxThreads; t *= 2)
+    {
+        threadCounts.push_back(t);
+    }
+    threadCounts.push_back(maxThreads);
+
+    std::vector<WorldBatch::Action> actions(static_cast<size_t>(worlds));
+    const ObservationGrid grid;
+    const size_t nearestCount = 16;
+    std::vector<float> gridOut(observe ? static_cast<size_t>(worlds) * grid.size() : 0);
+    std::vector<float> nearestOut(observe ? static_cast<size_t>(worlds) * nearestCount * ObservationNearest::FEATURES : 0);
+    double singleRate = 0.0;
+    for (long threads : threadCounts)
+    {
+        WorldBatch batch;
+        batch.init(config, static_cast<size_t>(worlds), static_cast<size_t>(threads), static_cast<int>(episode));
+
+        Rng rng(7);
+        double reward = 0.0;
+        long episodes = 0;
+        std::chrono::steady_clock::duration stepTime{};
+        std::chrono::steady_clock::duration gridTime{};
+        std::chrono::steady_clock::duration nearestTime{};
+        for (long tick = 0; tick < ticks; tick++)
+        {
+            for (auto &a : actions)
+            {
+                if (rng.uniformInt(0, 15) == 0) a.input = static_cast<std::uint8_t>(rng.uniformInt(0, 15));
+                a.shoot = rng.uniformInt(0, 7) == 0;
+                a.target = {rng.uniform(0.f, static_cast<float>(config.window.W)),
+                            rng.uniform(0.f, static_cast<float>(config.window.H))};
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            auto result = batch.step(actions);
+            stepTime += std::chrono::steady_clock::now() - start;
+
+            if (observe)
+            {
+                start = std::chrono::steady_clock::now();
+                batch.observe(grid, gridOut);
+                auto gridEnd = std::chrono::steady_clock::now();
+                batch.observeNearest(nearestCount, nearestOut);
+                gridTime += gridEnd - start;
+                nearestTime += std::chrono::steady_clock::now() - gridEnd;
+            }
+
+            for (size_t i = 0; i < result.rewards.size(); i++)
+            {
+                reward += result.rewards[i];
+                episodes += result.done[i];
+            }
+        }
+
+        const double seconds = std::chrono::duration<double>(stepTime).count();
+        const double rate = static_cast<double>(worlds) * static_cast<double>(ticks) / seconds;
+        if (threads == threadCounts.front()) singleRate = rate / static_cast<double>(threads);
+        std::cout << batch.threads() << " threads: " << worlds << " worlds x " << ticks << " ticks in " << seconds
+                  << " s, " << rate << " world ticks/s";
+        if (scaling)
+        {
+            std::cout << ", " << rate / singleRate << "x";
+        }
+        std::cout << " (" << episodes << " episodes ended, mean reward " << reward / static_cast<double>(worlds)
+                  << " per world)\n";
+        if (observe)
+        {
+            const double perWorld = 1e6 / (static_cast<double>(worlds) * static_cast<double>(ticks));
+            std::cout << "  observation per world: grid " << std::chrono::duration<double>(gridTime).count() * perWorld
+                      << " us, nearest " << std::chrono::duration<double>(nearestTime).count() * perWorld
+                      << " us, step " << seconds * perWorld << " us\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Append-only binary writer and bounds-checked reader for the replay and save
+// formats. Values are copied as they sit in memory (little-endian on every
+// platform we build for); counts and deltas use LEB128 varints.
+class ByteWriter
+{
+    std::vector<std::uint8_t> &m_out;
+
+  public:
+    explicit ByteWriter(std::vector<std::uint8_t> &out)
+        : m_out(out) {}
+
+    void putBytes(const void *data, size_t size)
+    {
+        const auto *p = static_cast<const std::uint8_t *>(data);
+        m_out.insert(m_out.end(), p, p + size);
+    }
+
+    template <typename T>
+    void put(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        putBytes(&value, sizeof(T));
+    }
+
+    void putVarint(std::uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            m_out.push_back(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        m_out.push_back(static_cast<std::uint8_t>(value));
+    }
+
+    void putString(const std::string &s)
+    {
+        putVarint(s.size());
+        putBytes(s.data(), s.size());
+    }
+
+    size_t size() const
+    {
+        return m_out.size();
+    }
+};
+
+// Every get fails once the input runs out and keeps failing, so callers can
+// read a whole record and check ok() once.
+class ByteReader
+{
+    const std::uint8_t *m_begin;
+    const std::uint8_t *m_p;
+    const std::uint8_t *m_end;
+    bool m_ok = true;
+
+  public:
+    ByteReader(const void *data, size_t size)
+        : m_begin(static_cast<const std::uint8_t *>(data)), m_p(m_begin), m_end(m_begin + size) {}
+
+    bool getBytes(void *out, size_t size)
+    {
+        if (!m_ok || static_cast<size_t>(m_end - m_p) < size)
+        {
+            m_ok = false;
+            return false;
+        }
+        std::memcpy(out, m_p, size);
+        m_p += size;
+        return true;
+    }
+
+    template <typename T>
+    bool get(T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return getBytes(&value, sizeof(T));
+    }
+
+    bool getVarint(std::uint64_t &value)
+    {
+        value = 0;
+        for (int shift = 0; m_ok && shift < 64; shift += 7)
+        {
+            if (m_p == m_end) break;
+            std::uint8_t byte = *m_p++;
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        m_ok = false;
+        return false;
+    }
+
+    bool getString(std::string &s)
+    {
+        std::uint64_t size = 0;
+        if (!getVarint(size) || size > remaining())
+        {
+            m_ok = false;
+            return false;
+        }
+        s.assign(reinterpret_cast<const char *>(m_p), static_cast<size_t>(size));
+        m_p += size;
+        return true;
+    }
+
+    // Hands out the next size bytes in place.
+    const std::uint8_t *skip(size_t size)
+    {
+        if (!m_ok || remaining() < size)
+        {
+            m_ok = false;
+            return nullptr;
+        }
+        const std::uint8_t *p = m_p;
+        m_p += size;
+        return p;
+    }
+
+    void seek(size_t offset)
+    {
+        m_p = m_begin + std::min(offset, static_cast<size_t>(m_end - m_begin));
+    }
+
+    size_t position() const
+    {
+        return static_cast<size_t>(m_p - m_begin);
+    }
+
+    size_t remaining() const
+    {
+        return static_cast<size_t>(m_end - m_p);
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+};
@@ -0,0 +1,322 @@
+#include "CollisionQuery.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Narrows [t0, t1] to where o + t * d lies in [lo, hi].
+void clip(float o, float d, float lo, float hi, float &t0, float &t1)
+{
+    if (d == 0.f)
+    {
+        if (o < lo || o > hi) t1 = -1.f;
+        return;
+    }
+    float a = (lo - o) / d;
+    float b = (hi - o) / d;
+    if (a > b) std::swap(a, b);
+    t0 = std::max(t0, a);
+    t1 = std::min(t1, b);
+}
+
+bool nearer(const RayHit &a, const RayHit &b)
+{
+    return a.distance != b.distance ? a.distance < b.distance : a.entity->id() < b.entity->id();
+}
+}
+
+void CollisionQuery::build(std::initializer_list<const EntityVec *> lists, const Vec2<float> &bounds)
+{
+    size_t capacity = 0;
+    for (const EntityVec *list : lists)
+    {
+        capacity += list->size();
+    }
+    clear(bounds, capacity);
+
+    std::uint32_t layer = 1;
+    for (const EntityVec *list : lists)
+    {
+        for (Entity *e : *list)
+        {
+            if (!e->isAlive() || !e->has<CTransform>() || !e->has<CCollision>()) continue;
+            add(e, e->get<CTransform>().pos, e->get<CCollision>().radius, layer);
+        }
+        layer <<= 1;
+    }
+    index();
+}
+
+void CollisionQuery::clear(const Vec2<float> &bounds, size_t capacity)
+{
+    if (m_gathered.entities.size() < capacity) m_gathered.resize(capacity);
+    m_count = 0;
+    m_bounds = bounds;
+    m_measured = false;
+    m_indexed = false;
+}
+
+void CollisionQuery::measure()
+{
+    if (m_measured) return;
+    m_measured = true;
+    const Bodies &in = m_gathered;
+    m_low = Vec2<float>(0.f, 0.f);
+    m_high = m_bounds;
+    m_maxRadius = 0.5f;
+    for (size_t i = 0; i < m_count; i++)
+    {
+        m_low = Vec2<float>(std::min(m_low.x, in.x[i]), std::min(m_low.y, in.y[i]));
+        m_high = Vec2<float>(std::max(m_high.x, in.x[i]), std::max(m_high.y, in.y[i]));
+        m_maxRadius = std::max(m_maxRadius, in.radius[i]);
+    }
+}
+
+void CollisionQuery::index()
+{
+    if (m_indexed) return;
+    m_indexed = true;
+    measure();
+    const Bodies &in = m_gathered;
+    const size_t n = m_count;
+
+    // with cells a diameter wide, a centre close enough to touch a thin ray
+    // is in a cell the ray crosses or one next to it
+    m_grid.build(std::span(in.x).first(n), std::span(in.y).first(n), m_low, m_high - m_low, 2.f * m_maxRadius);
+
+    const auto order = m_grid.items();
+    m_bodies.resize(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        const std::uint32_t i = order[k];
+        m_bodies.entities[k] = in.entities[i];
+        m_bodies.x[k] = in.x[i];
+        m_bodies.y[k] = in.y[i];
+        m_bodies.radius[k] = in.radius[i];
+        m_bodies.layer[k] = in.layer[i];
+    }
+}
+
+void CollisionQuery::raycast(const Ray &ray, std::vector<RayHit> &hits, size_t maxHits)
+{
+    hits.clear();
+    index();
+    if (m_bodies.entities.empty() || maxHits == 0) return;
+
+    const float ox = ray.origin.x;
+    const float oy = ray.origin.y;
+    const float dx = ray.dir.x;
+    const float dy = ray.dir.y;
+    const Vec2<float> &corner = m_grid.corner();
+    const float cell = m_grid.cellSize();
+    const int width = m_grid.width();
+    const int height = m_grid.height();
+
+    // a body touches the ray only with its centre within reach of it, which
+    // is within around cells of some cell the ray crosses
+    const float reach = m_maxRadius + ray.radius;
+    const int around = static_cast<int>(std::ceil(reach / cell));
+
+    // the part of the ray that can touch anything is within reach of the grid
+    float t0 = 0.f;
+    float t1 = ray.length;
+    clip(ox - corner.x, dx, -reach, static_cast<float>(width) * cell + reach, t0, t1);
+    clip(oy - corner.y, dy, -reach, static_cast<float>(height) * cell + reach, t0, t1);
+    if (t0 > t1) return;
+
+    auto test = [&](size_t j)
+    {
+        const float fx = m_bodies.x[j] - ox;
+        const float fy = m_bodies.y[j] - oy;
+        const float along = fx * dx + fy * dy;
+        const float r = m_bodies.radius[j] + ray.radius;
+        const float off2 = fx * fx + fy * fy - along * along;
+        if (off2 > r * r) return;
+
+        const float half = std::sqrt(r * r - off2);
+        if (along + half < 0.f || along - half > ray.length) return;
+        hits.push_back({m_bodies.entities[j], std::max(along - half, 0.f)});
+    };
+    auto visit = [&](int x0, int x1, int y0, int y1)
+    {
+        x0 = std::max(x0, 0);
+        x1 = std::min(x1, width - 1);
+        if (x0 > x1) return;
+        for (int y = std::max(y0, 0); y <= std::min(y1, height - 1); y++)
+        {
+            const auto [first, last] = m_grid.rowRange(y, x0, x1);
+            for (std::uint32_t j = first; j < last; j++)
+            {
+                test(j);
+            }
+        }
+    };
+
+    // cells are counted from the grid's corner and may lie outside it, where
+    // the walk goes on for as long as the ray stays within reach
+    const float gx = ox - corner.x;
+    const float gy = oy - corner.y;
+    int cx = static_cast<int>(std::floor((gx + dx * t0) / cell));
+    int cy = static_cast<int>(std::floor((gy + dy * t0) / cell));
+    const int stepX = dx > 0.f ? 1 : -1;
+    const int stepY = dy > 0.f ? 1 : -1;
+    // the ray's t at the next column and row boundary, and from one to the next
+    constexpr float NEVER = std::numeric_limits<float>::infinity();
+    float nextX = dx != 0.f ? (static_cast<float>(cx + (dx > 0.f)) * cell - gx) / dx : NEVER;
+    float nextY = dy != 0.f ? (static_cast<float>(cy + (dy > 0.f)) * cell - gy) / dy : NEVER;
+    const float deltaX = dx != 0.f ? cell / std::abs(dx) : NEVER;
+    const float deltaY = dy != 0.f ? cell / std::abs(dy) : NEVER;
+
+    // the furthest of the nearest maxHits hits, once there are that many
+    float cutoff = NEVER;
+    float enter = t0;
+    visit(cx - around, cx + around, cy - around, cy + around);
+    for (;;)
+    {
+        if (hits.size() >= maxHits)
+        {
+            std::nth_element(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(maxHits - 1), hits.end(), nearer);
+            hits.resize(maxHits);
+            cutoff = hits.back().distance;
+        }
+
+        const bool column = nextX < nextY;
+        if (column)
+        {
+            if (nextX > t1) break;
+            enter = nextX;
+            nextX += deltaX;
+            cx += stepX;
+        }
+        else
+        {
+            if (nextY > t1) break;
+            enter = nextY;
+            nextY += deltaY;
+            cy += stepY;
+        }
+
+        // a body not tested yet touches the ray no nearer than this
+        if (enter - 2.f * reach > cutoff) break;
+
+        // the block's new leading column or row
+        if (column)
+        {
+            visit(cx + stepX * around, cx + stepX * around, cy - around, cy + around);
+        }
+        else
+        {
+            visit(cx - around, cx + around, cy + stepY * around, cy + stepY * around);
+        }
+    }
+
+    std::sort(hits.begin(), hits.end(), nearer);
+}
+
+void CollisionQuery::raycast(std::span<const Ray> rays, std::span<RayHit> nearest)
+{
+    for (size_t i = 0; i < rays.size(); i++)
+    {
+        raycast(rays[i], m_nearest, 1);
+        nearest[i] = m_nearest.empty() ? RayHit{} : m_nearest.front();
+    }
+}
+
+size_t CollisionQuery::queryCircle(const Vec2<float> &center, float radius, std::uint32_t layerMask,
+                                   std::span<Entity *> out)
+{
+    size_t count = 0;
+    if (m_count == 0 || out.empty()) return 0;
+
+    // a body overlaps the circle with its centre within reach of the centre
+    measure();
+    const float reach = radius + m_maxRadius;
+
+    // both return false once out is full
+    auto take = [&](std::uint32_t first, std::uint32_t last)
+    {
+        for (std::uint32_t j = first; j < last; j++)
+        {
+            if (!(m_bodies.layer[j] & layerMask)) continue;
+            out[count++] = m_bodies.entities[j];
+            if (count == out.size()) return false;
+        }
+        return true;
+    };
+    auto test = [&](const Bodies &bodies, std::uint32_t first, std::uint32_t last)
+    {
+        for (std::uint32_t j = first; j < last; j++)
+        {
+            if (!(bodies.layer[j] & layerMask)) continue;
+            const float dx = bodies.x[j] - center.x;
+            const float dy = bodies.y[j] - center.y;
+            const float r = radius + bodies.radius[j];
+            if (dx * dx + dy * dy > r * r) continue;
+            out[count++] = bodies.entities[j];
+            if (count == out.size()) return false;
+        }
+        return true;
+    };
+
+    // a circle reaching past every side would visit every cell, so until
+    // something needs the grid it is answered from the bodies as added
+    if (!m_indexed && center.x - reach <= m_low.x && center.x + reach >= m_high.x && center.y - reach <= m_low.y &&
+        center.y + reach >= m_high.y)
+    {
+        test(m_gathered, 0, static_cast<std::uint32_t>(m_count));
+        return count;
+    }
+
+    index();
+    const Vec2<float> &corner = m_grid.corner();
+    const float cell = m_grid.cellSize();
+    const int y0 = m_grid.cellY(center.y - reach);
+    const int y1 = m_grid.cellY(center.y + reach);
+
+    for (int y = y0; y <= y1; y++)
+    {
+        // the nearest and furthest the row gets to the centre vertically
+        const float top = corner.y + static_cast<float>(y) * cell - center.y;
+        const float bottom = top + cell;
+        const float nearY = top > 0.f ? top : bottom < 0.f ? -bottom : 0.f;
+        const float farY = std::max(std::abs(top), std::abs(bottom));
+        if (nearY > reach) continue;
+
+        const float half = std::sqrt(reach * reach - nearY * nearY);
+        const int x0 = m_grid.cellX(center.x - half);
+        const int x1 = m_grid.cellX(center.x + half);
+
+        // cells with every corner inside the circle
+        int in0 = x1 + 1;
+        int in1 = x1;
+        if (farY < radius)
+        {
+            const float inner = std::sqrt(radius * radius - farY * farY);
+            in0 = std::max(x0, static_cast<int>(std::ceil((center.x - inner - corner.x) / cell)));
+            in1 = std::min(x1, static_cast<int>(std::floor((center.x + inner - corner.x) / cell)) - 1);
+            if (in0 > in1)
+            {
+                in0 = x1 + 1;
+                in1 = x1;
+            }
+        }
+
+        if (in0 > x0)
+        {
+            const auto [first, last] = m_grid.rowRange(y, x0, in0 - 1);
+            if (!test(m_bodies, first, last)) return count;
+        }
+        if (in0 <= in1)
+        {
+            const auto [first, last] = m_grid.rowRange(y, in0, in1);
+            if (!take(first, last)) return count;
+        }
+        if (in1 < x1)
+        {
+            const auto [first, last] = m_grid.rowRange(y, in1 + 1, x1);
+            if (!test(m_bodies, first, last)) return count;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "EntityManager.hpp"
+#include "SpatialGrid.hpp"
+#include "Vec2.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <span>
+#include <vector>
+
+// The segment from origin along the unit vector dir for length. A radius
+// sweeps a circle along it instead of a point.
+struct Ray
+{
+    Vec2<float> origin;
+    Vec2<float> dir;
+    float length = 0.f;
+    float radius = 0.f;
+};
+
+struct RayHit
+{
+    Entity *entity = nullptr;
+    // along the ray to where it first touches the entity's collision circle
+    float distance = 0.f;
+};
+
+// Queries against entities' collision circles. build() takes the positions
+// of a set of entity lists into a SpatialGrid, stored in cell order like
+// ContactSolver's bodies, and queries see those positions until the next
+// build. The k-th list is layer 1 << k for queries that take a layer mask.
+// A caller already walking the entities can instead clear() and add() each
+// body, sparing the gather its own pass over them. Either way the bodies are
+// bucketed by the first query that needs the grid.
+//
+// A raycast walks the cells the ray crosses with a 2D DDA (Amanatides & Woo),
+// nearest first, testing the bodies in the block of cells around each one
+// that can hold a centre close enough to touch it. The walk only ever moves
+// one way along each axis, so each step adds one new column or row of the
+// block and no body is looked at twice. Only cells along the ray are
+// visited, and once enough hits are known to be nearer than anything further
+// on could be, the walk stops.
+//
+// A circle query looks at the rows of cells the circle spans. Along each
+// row, the cells lying wholly inside the circle are one contiguous run of
+// bodies taken without testing any, leaving distance tests to the cells on
+// the rim. A circle reaching past every side of the grid would take every
+// row whole, so before the bodies are bucketed it tests them as added
+// instead, and bucketing is left to a query that gains by it.
+class CollisionQuery
+{
+    struct Bodies
+    {
+        std::vector<Entity *> entities;
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> radius;
+        std::vector<std::uint32_t> layer;
+
+        void resize(size_t n)
+        {
+            entities.resize(n);
+            x.resize(n);
+            y.resize(n);
+            radius.resize(n);
+            layer.resize(n);
+        }
+    };
+
+    // the first m_count read in list order, then stored in cell order
+    Bodies m_gathered;
+    size_t m_count = 0;
+    Bodies m_bodies;
+    // over the bounds and every body, so it can start left of or above the
+    // origin
+    SpatialGrid m_grid;
+    Vec2<float> m_bounds;
+    Vec2<float> m_low;
+    Vec2<float> m_high;
+    float m_maxRadius = 0.f;
+    bool m_measured = true;
+    bool m_indexed = true;
+    std::vector<RayHit> m_nearest;
+
+    // the extent and largest radius of what was added since clear(), and
+    // then its buckets, each worked out once
+    void measure();
+    void index();
+
+  public:
+    void build(std::initializer_list<const EntityVec *> lists, const Vec2<float> &bounds);
+
+    // Starts a gather over bounds with room for capacity bodies, so adding
+    // that many doesn't allocate.
+    void clear(const Vec2<float> &bounds, size_t capacity = 0);
+
+    // Only stores the body, to stay cheap inside another pass over the
+    // entities; anything that depends on all of them waits for a query.
+    void add(Entity *e, const Vec2<float> &pos, float radius, std::uint32_t layer)
+    {
+        if (m_count == m_gathered.entities.size())
+        {
+            m_gathered.resize(std::max<size_t>(2 * m_count, 64));
+        }
+        m_gathered.entities[m_count] = e;
+        m_gathered.x[m_count] = pos.x;
+        m_gathered.y[m_count] = pos.y;
+        m_gathered.radius[m_count] = radius;
+        m_gathered.layer[m_count] = layer;
+        m_count++;
+    }
+
+    // Every entity the ray touches, nearest first, or the nearest maxHits of
+    // them. Ties go to the lower entity id.
+    void raycast(const Ray &ray, std::vector<RayHit> &hits, size_t maxHits = std::numeric_limits<size_t>::max());
+
+    // The nearest hit of each ray, with a null entity where nothing is in the
+    // way: line of sight for many rays against one build.
+    void raycast(std::span<const Ray> rays, std::span<RayHit> nearest);
+
+    // Writes the entities on layerMask whose collision circle overlaps the
+    // circle into out, in no particular order, and returns how many. Stops
+    // when out is full.
+    size_t queryCircle(const Vec2<float> &center, float radius, std::uint32_t layerMask,
+                       std::span<Entity *> out);
+
+    size_t size() const
+    {
+        return m_count;
+    }
+
+    // as of the last query that bucketed the bodies
+    const SpatialGrid &grid() const
+    {
+        return m_grid;
+    }
+};
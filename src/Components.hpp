@@ -1,7 +1,8 @@
 #pragma once
 
 #include "Vec2.hpp"
-#include <SFML/Graphics.hpp>
+#include <SFML/Graphics/Color.hpp>
+#include <cstddef>
 
 class Component
 {
@@ -22,20 +23,20 @@ public:
         : pos(p), velocity(v), angle(a), angVel(av) {}
 };
 
+// Plain description of a regular polygon; ShapeBatch turns it into vertices
+// at render time so the simulation never needs an SFML drawable.
 class CShape : public Component
 {
 public:
-    sf::CircleShape circle;
+    float radius = 0.f;
+    size_t points = 0;
+    sf::Color fill;
+    sf::Color outline;
+    float thickness = 0.f;
 
     CShape() = default;
-    CShape(float radius, size_t points, const sf::Color &fill, const sf::Color &outline, float thickness)
-        : circle(radius, points)
-    {
-        circle.setFillColor(fill);
-        circle.setOutlineColor(outline);
-        circle.setOutlineThickness(thickness);
-        circle.setOrigin({radius, radius});
-    }
+    CShape(float r, size_t p, const sf::Color &f, const sf::Color &o, float t)
+        : radius(r), points(p), fill(f), outline(o), thickness(t) {}
 };
 
 class CCollision : public Component
@@ -0,0 +1,188 @@
+#include "Config.h"
+#include "World.h"
+
+#include <fstream>
+#include <iostream>
+
+bool loadConfig(const std::string &path, GameConfig &config)
+{
+    std::string type;
+
+    bool windowCfgRead = false;
+    bool fontCfgRead = false;
+    bool playerCfgRead = false;
+    bool enemyCfgRead = false;
+    bool bulletCfgRead = false;
+
+    std::ifstream inputFile(path);
+    if (!inputFile.is_open())
+    {
+        std::cerr << "Error: Could not open the file!\n";
+        return false;
+    }
+
+    auto &w = config.window;
+    auto &f = config.font;
+    auto &p = config.player;
+    auto &e = config.enemy;
+    auto &b = config.bullet;
+
+    while (inputFile >> type)
+    {
+        if (type == "Window")
+        {
+            if (!(inputFile >> w.W >> w.H >> w.FPS))
+            {
+                std::cerr << "Error: Malformed Window section in config\n";
+                return false;
+            }
+            windowCfgRead = true;
+        }
+        else if (type == "Font")
+        {
+            if (!(inputFile >> f.F >> f.S))
+            {
+                std::cerr << "Error: Malformed Font section in config\n";
+                return false;
+            }
+            fontCfgRead = true;
+        }
+        else if (type == "Player")
+        {
+            if (!(inputFile >> p.SR >> p.CR >> p.FR >> p.FG >> p.FB >> p.OR >> p.OG >> p.OB >>
+                  p.OT >> p.V >> p.S))
+            {
+                std::cerr << "Error: Malformed Player section in config\n";
+                return false;
+            }
+            playerCfgRead = true;
+        }
+        else if (type == "Enemy")
+        {
+            if (!(inputFile >> e.SR >> e.CR >> e.OR >> e.OG >> e.OB >> e.OT >> e.VMIN >> e.VMAX >>
+                  e.L >> e.SI >> e.SMIN >> e.SMAX))
+            {
+                std::cerr << "Error: Malformed Enemy section in config\n";
+                return false;
+            }
+            enemyCfgRead = true;
+        }
+        else if (type == "Bullet")
+        {
+            if (!(inputFile >> b.SR >> b.CR >> b.FR >> b.FG >> b.FB >> b.OR >> b.OG >> b.OB >>
+                  b.OT >> b.V >> b.L >> b.S))
+            {
+                std::cerr << "Error: Malformed Bullet section in config\n";
+                return false;
+            }
+            bulletCfgRead = true;
+        }
+        else if (type == "Particles")
+        {
+            if (!(inputFile >> config.particles.MAX >> config.particles.S))
+            {
+                std::cerr << "Error: Malformed Particles section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Seed")
+        {
+            if (!(inputFile >> config.seed.VALUE))
+            {
+                std::cerr << "Error: Malformed Seed section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Deterministic")
+        {
+            if (!(inputFile >> config.deterministic.ENABLED))
+            {
+                std::cerr << "Error: Malformed Deterministic section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Net")
+        {
+            if (!(inputFile >> config.net.HOST >> config.net.PORT >> config.net.RATE) || config.net.RATE <= 0)
+            {
+                std::cerr << "Error: Malformed Net section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Chase")
+        {
+            auto &c = config.chase;
+            if (!(inputFile >> c.ENEMY >> c.SMALL >> c.STEER >> c.CELL) || c.CELL <= 0)
+            {
+                std::cerr << "Error: Malformed Chase section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Physics")
+        {
+            auto &ph = config.physics;
+            if (!(inputFile >> ph.ENABLED >> ph.RESTITUTION >> ph.ITERATIONS) || ph.ITERATIONS < 1)
+            {
+                std::cerr << "Error: Malformed Physics section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Polygons")
+        {
+            if (!(inputFile >> config.polygons.ENABLED))
+            {
+                std::cerr << "Error: Malformed Polygons section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Special")
+        {
+            auto &s = config.special;
+            if (!(inputFile >> s.WEAPON >> s.RADIUS >> s.KILL >> s.PUSH) || s.WEAPON < 0 ||
+                s.WEAPON >= static_cast<int>(World::SpecialWeapon::Count))
+            {
+                std::cerr << "Error: Malformed Special section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Pool")
+        {
+            if (!(inputFile >> config.pool.BULLETS >> config.pool.SMALL_ENEMIES))
+            {
+                std::cerr << "Error: Malformed Pool section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Rewind")
+        {
+            auto &r = config.rewind;
+            if (!(inputFile >> r.ENABLED >> r.EVERY >> r.MB))
+            {
+                std::cerr << "Error: Malformed Rewind section in config\n";
+                return false;
+            }
+        }
+        else if (type == "Gui")
+        {
+            if (!(inputFile >> config.gui.RATE))
+            {
+                std::cerr << "Error: Malformed Gui section in config\n";
+                return false;
+            }
+        }
+        else
+        {
+            std::cerr << "Warning: Unknown config section '" << type << "'\n";
+            std::string discard;
+            std::getline(inputFile, discard);
+        }
+    }
+
+    if (!(windowCfgRead && fontCfgRead && playerCfgRead && enemyCfgRead && bulletCfgRead))
+    {
+        std::cerr << "Error: Missing required config sections\n";
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct WindowConfig
+{
+    int W = 1280;
+    int H = 720;
+    int FPS = 60;
+};
+struct FontConfig
+{
+    std::string F;
+    int S = 18;
+};
+struct PlayerConfig
+{
+    int SR, CR, FR, FG, FB, OR, OG, OB, OT, V;
+    float S;
+};
+struct EnemyConfig
+{
+    int SR, CR, OR, OG, OB, OT, VMIN, VMAX, L, SI;
+    float SMIN, SMAX;
+};
+struct BulletConfig
+{
+    int SR, CR, FR, FG, FB, OR, OG, OB, OT, V, L;
+    float S;
+};
+struct ParticleConfig
+{
+    int MAX = 200000;
+    float S = 2.f;
+};
+
+// Debug GUI refresh rate in Hz; 0 rebuilds it every frame.
+struct GuiConfig
+{
+    float RATE = 0.f;
+};
+
+// Seed for every simulation random stream; 0 picks a new one each run.
+struct SeedConfig
+{
+    std::uint64_t VALUE = 0;
+};
+
+// Lockstep mode: fixed-size ticks and a seed, so identical input gives a
+// bit-identical world (see World::hash).
+struct DeterministicConfig
+{
+    int ENABLED = 0;
+};
+
+// Networking. HOST is the server a windowed Game joins as a client ("-"
+// simulates locally); the dedicated server listens on PORT and sends RATE
+// snapshots a second.
+struct NetConfig
+{
+    std::string HOST = "-";
+    int PORT = 40000;
+    int RATE = 20;
+};
+
+// Homing. ENEMY and SMALL switch it on for big and small enemies; chasers
+// turn toward the flow field's heading at STEER per second, sampling a field
+// of CELL-pixel cells.
+struct ChaseConfig
+{
+    int ENEMY = 0;
+    int SMALL = 0;
+    float STEER = 3.f;
+    int CELL = 40;
+};
+
+// Enemy-enemy collisions. With ENABLED, enemies and small enemies bounce
+// off each other with RESTITUTION (1 is perfectly elastic) and are pushed
+// apart over ITERATIONS relaxation passes a tick.
+struct PhysicsConfig
+{
+    int ENABLED = 0;
+    float RESTITUTION = 0.8f;
+    int ITERATIONS = 2;
+};
+
+// Exact hit tests. With ENABLED, pairs that overlap as circles are tested
+// again against the polygons as drawn, so empty corners of the circle no
+// longer hit.
+struct PolygonConfig
+{
+    int ENABLED = 0;
+};
+
+// The right-click weapons. WEAPON is the one selected at start: 0 is the
+// laser, 1 the shockwave. The shockwave destroys enemies within KILL of the
+// player and throws the rest within RADIUS outward by up to PUSH pixels.
+struct SpecialConfig
+{
+    int WEAPON = 0;
+    float RADIUS = 600.f;
+    float KILL = 150.f;
+    float PUSH = 120.f;
+};
+
+// Rewind capture for the debug GUI. With ENABLED the game snapshots the
+// world every EVERY ticks into a ring of at most MB megabytes. Off, nothing
+// is captured; the Systems tab can still turn it on.
+struct RewindConfig
+{
+    int ENABLED = 0;
+    int EVERY = 1;
+    int MB = 256;
+};
+
+// Preallocated room for the entities spawned in bulk: BULLETS and
+// SMALL_ENEMIES alive at once spawn without allocating.
+struct PoolConfig
+{
+    int BULLETS = 0;
+    int SMALL_ENEMIES = 0;
+};
+
+struct GameConfig
+{
+    WindowConfig window;
+    FontConfig font;
+    PlayerConfig player{};
+    EnemyConfig enemy{};
+    BulletConfig bullet{};
+    ParticleConfig particles;
+    GuiConfig gui;
+    SeedConfig seed;
+    DeterministicConfig deterministic;
+    NetConfig net;
+    ChaseConfig chase;
+    PhysicsConfig physics;
+    PolygonConfig polygons;
+    SpecialConfig special;
+    PoolConfig pool;
+    RewindConfig rewind;
+};
+
+// Reads the config file at path into config. Prints the reason and returns
+// false if the file is missing, malformed or lacks a required section.
+bool loadConfig(const std::string &path, GameConfig &config);
@@ -0,0 +1,209 @@
+#include "ContactSolver.h"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+void ContactSolver::solve(std::initializer_list<const EntityVec *> lists, const PhysicsConfig &config,
+                          const Vec2<float> &bounds, ThreadPool *pool)
+{
+    m_entities.clear();
+    for (const EntityVec *list : lists)
+    {
+        for (Entity *e : *list)
+        {
+            if (e->isAlive() && e->has<CTransform>() && e->has<CCollision>()) m_entities.push_back(e);
+        }
+    }
+
+    const size_t n = m_entities.size();
+    m_contacts = 0;
+    if (n < 2) return;
+
+    {
+        PROFILE_SCOPE("collision/contacts/gather");
+        // read in entity order into m_next, which is free until the first
+        // pass, and m_invMass, which holds radii until the bodies are sorted
+        m_maxRadius = 0.f;
+        m_next.resize(n);
+        m_invMass.resize(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            const auto &t = m_entities[i]->get<CTransform>();
+            m_next.x[i] = t.pos.x;
+            m_next.y[i] = t.pos.y;
+            m_next.vx[i] = t.velocity.x;
+            m_next.vy[i] = t.velocity.y;
+            m_invMass[i] = std::max(m_entities[i]->get<CCollision>().radius, 0.5f);
+            m_maxRadius = std::max(m_maxRadius, m_invMass[i]);
+        }
+
+        // any two touching bodies are at most one cell apart
+        m_grid.build(std::span(m_next.x).first(n), std::span(m_next.y).first(n), bounds, 2.f * m_maxRadius);
+
+        // bodies are stored in cell order from here on, so the neighbours
+        // a body looks at sit together in memory
+        m_order.assign(m_grid.items().begin(), m_grid.items().end());
+        m_current.resize(n);
+        m_radius.resize(n);
+        for (size_t k = 0; k < n; k++)
+        {
+            const std::uint32_t i = m_order[k];
+            m_current.x[k] = m_next.x[i];
+            m_current.y[k] = m_next.y[i];
+            m_current.vx[k] = m_next.vx[i];
+            m_current.vy[k] = m_next.vy[i];
+            m_radius[k] = m_invMass[i];
+        }
+        for (size_t k = 0; k < n; k++)
+        {
+            m_invMass[k] = 1.f / (m_radius[k] * m_radius[k]);
+        }
+    }
+
+    PROFILE_SCOPE("collision/contacts/relax");
+    m_touching.resize(pool ? pool->size() : 1);
+    m_hits.resize(n);
+    for (int pass = 0; pass < config.ITERATIONS; pass++)
+    {
+        // every body's contacts are counted before any impulse is split
+        if (pool && pool->size() > 1)
+        {
+            const size_t workers = pool->size();
+            std::atomic<std::uint64_t> contacts = 0;
+            const std::function<void(size_t)> find = [&](size_t worker)
+            { contacts += findContacts(n * worker / workers, n * (worker + 1) / workers, m_touching[worker]); };
+            const std::function<void(size_t)> resolve = [&](size_t worker)
+            { relax(n * worker / workers, n * (worker + 1) / workers, config.RESTITUTION, m_touching[worker]); };
+            pool->run(find);
+            pool->run(resolve);
+            m_contacts = contacts;
+        }
+        else
+        {
+            m_contacts = findContacts(0, n, m_touching[0]);
+            relax(0, n, config.RESTITUTION, m_touching[0]);
+        }
+        std::swap(m_current, m_next);
+    }
+
+    for (size_t k = 0; k < n; k++)
+    {
+        auto &t = m_entities[m_order[k]]->get<CTransform>();
+        t.pos = Vec2<float>(m_current.x[k], m_current.y[k]);
+        t.velocity = Vec2<float>(m_current.vx[k], m_current.vy[k]);
+    }
+}
+
+std::uint64_t ContactSolver::findContacts(size_t begin, size_t end, std::vector<std::uint32_t> &touching)
+{
+    const Bodies &in = m_current;
+    size_t used = 0;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const float xi = in.x[i];
+        const float yi = in.y[i];
+        const float ri = m_radius[i];
+
+        // the grid still holds the positions the tick started with; bodies
+        // move less than a cell while relaxing, so its rows stand
+        const float reachMax = ri + m_maxRadius;
+        const int x0 = m_grid.cellX(xi - reachMax);
+        const int x1 = m_grid.cellX(xi + reachMax);
+        const int y0 = m_grid.cellY(yi - reachMax);
+        const int y1 = m_grid.cellY(yi + reachMax);
+
+        // In a swarm a third or more of the candidates touch, in no pattern a
+        // branch predictor can follow, so the overlap test writes every
+        // candidate and only advances past the ones that hit.
+        size_t hits = used;
+        for (int cy = y0; cy <= y1; cy++)
+        {
+            const auto [first, last] = m_grid.rowRange(cy, x0, x1);
+            if (hits + (last - first) > touching.size()) touching.resize(hits + (last - first));
+            for (std::uint32_t j = first; j < last; j++)
+            {
+                const float nx = in.x[j] - xi;
+                const float ny = in.y[j] - yi;
+                const float reach = ri + m_radius[j];
+                touching[hits] = j;
+                hits += (nx * nx + ny * ny < reach * reach) & (j != i);
+            }
+        }
+        m_hits[i] = static_cast<std::uint32_t>(hits - used);
+        used = hits;
+    }
+    return used;
+}
+
+void ContactSolver::relax(size_t begin, size_t end, float restitution, const std::vector<std::uint32_t> &touching)
+{
+    const Bodies &in = m_current;
+    Bodies &out = m_next;
+    size_t next = 0;
+
+    for (size_t i = begin; i < end; i++)
+    {
+        const float xi = in.x[i];
+        const float yi = in.y[i];
+        const float vxi = in.vx[i];
+        const float vyi = in.vy[i];
+        const float invMi = m_invMass[i];
+        const std::uint32_t hits = m_hits[i];
+
+        float dx = 0.f;
+        float dy = 0.f;
+        float dvx = 0.f;
+        float dvy = 0.f;
+
+        for (std::uint32_t h = 0; h < hits; h++)
+        {
+            const std::uint32_t j = touching[next + h];
+            float nx = in.x[j] - xi;
+            float ny = in.y[j] - yi;
+            const float reach = m_radius[i] + m_radius[j];
+
+            // coincident centres separate along x, lower index to the left
+            const float d = std::sqrt(nx * nx + ny * ny);
+            if (d > 0.f)
+            {
+                nx /= d;
+                ny /= d;
+            }
+            else
+            {
+                nx = j > i ? 1.f : -1.f;
+                ny = 0.f;
+            }
+
+            // this body's share of the pair's correction, by inverse mass
+            const float share = invMi / (invMi + m_invMass[j]);
+            dx -= nx * (reach - d) * share;
+            dy -= ny * (reach - d) * share;
+
+            // The impulse treats each body's mass as split evenly between
+            // its contacts, so that a crowd's impulses add up to no more
+            // than one collision's. Both bodies see the same split, so the
+            // pair's impulses stay equal and opposite.
+            const float approach = (in.vx[j] - vxi) * nx + (in.vy[j] - vyi) * ny;
+            if (approach < 0.f)
+            {
+                const float split = invMi / (static_cast<float>(hits) * invMi +
+                                             static_cast<float>(m_hits[j]) * m_invMass[j]);
+                dvx += nx * (1.f + restitution) * approach * split;
+                dvy += ny * (1.f + restitution) * approach * split;
+            }
+        }
+        next += hits;
+
+        // the push apart is averaged so a body in a crowd isn't moved once
+        // per neighbour
+        const float scale = hits > 0 ? 1.f / static_cast<float>(hits) : 0.f;
+        out.x[i] = xi + dx * scale;
+        out.y[i] = yi + dy * scale;
+        out.vx[i] = vxi + dvx;
+        out.vy[i] = vyi + dvy;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Config.h"
+#include "EntityManager.hpp"
+#include "SpatialGrid.hpp"
+#include "ThreadPool.hpp"
+#include "Vec2.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Elastic collisions between circles. Each tick the bodies are copied out of
+// their CTransform and CCollision into flat arrays, bucketed in a
+// SpatialGrid, relaxed and written back. Mass goes with area, so radius
+// squared.
+//
+// The solver is Jacobi: every pass computes each body's correction from its
+// overlapping neighbours as they were at the start of the pass and applies
+// all of them at once, the push apart averaged over the neighbours and the
+// impulses with each body's mass split between its contacts, which keeps
+// momentum. A body only ever writes its own result, so
+// the bodies can be split across threads and the outcome doesn't depend on
+// the split or the order.
+class ContactSolver
+{
+    struct Bodies
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> vx;
+        std::vector<float> vy;
+
+        void resize(size_t n)
+        {
+            x.resize(n);
+            y.resize(n);
+            vx.resize(n);
+            vy.resize(n);
+        }
+    };
+
+    std::vector<Entity *> m_entities;
+    // m_entities index of each body, bodies being in grid cell order
+    std::vector<std::uint32_t> m_order;
+    std::vector<float> m_radius;
+    std::vector<float> m_invMass;
+    Bodies m_current;
+    Bodies m_next;
+    SpatialGrid m_grid;
+    // per worker, the neighbours overlapping each of its bodies in turn
+    std::vector<std::vector<std::uint32_t>> m_touching;
+    // how many neighbours overlap each body
+    std::vector<std::uint32_t> m_hits;
+    float m_maxRadius = 0.f;
+    std::uint64_t m_contacts = 0;
+
+    std::uint64_t findContacts(size_t begin, size_t end, std::vector<std::uint32_t> &touching);
+    void relax(size_t begin, size_t end, float restitution, const std::vector<std::uint32_t> &touching);
+
+  public:
+    // Resolves overlaps among the entities of every list in one set, on pool
+    // if there is one.
+    void solve(std::initializer_list<const EntityVec *> lists, const PhysicsConfig &config, const Vec2<float> &bounds,
+               ThreadPool *pool);
+
+    // overlapping pairs seen in the last solve, counted once per body
+    std::uint64_t contacts() const
+    {
+        return m_contacts;
+    }
+
+    const SpatialGrid &grid() const
+    {
+        return m_grid;
+    }
+};
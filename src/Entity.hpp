@@ -1,11 +1,17 @@
 #pragma once
 
 #include "Components.hpp"
+#include <map>
 #include <string>
 #include <tuple>
+#include <vector>
 
+class Entity;
 class EntityManager;
 
+using EntityVec = std::vector<Entity *>;
+using EntityMap = std::map<std::string, EntityVec>;
+
 using ComponentTuple = std::tuple<
     CTransform,
     CShape,
@@ -20,12 +26,14 @@ class Entity
 
     ComponentTuple m_components;
     bool m_alive = true;
-    std::string m_tag = "default";
+    // the tag's entry in the EntityManager's map: the interned name, so
+    // copying an entity never touches the heap, and the list it goes in
+    EntityMap::value_type *m_tag = nullptr;
     size_t m_id = 0;
 
 public:
     Entity() = default;
-    Entity(const std::string &tag, size_t id)
+    Entity(EntityMap::value_type *tag, size_t id)
         : m_tag(tag), m_id(id) {}
 
     template <typename T, typename... Args>
@@ -66,6 +74,7 @@ public:
 
     const std::string &tag() const
     {
-        return m_tag;
+        static const std::string none = "default";
+        return m_tag ? m_tag->first : none;
     }
 };
@@ -1,44 +1,396 @@
 #pragma once
+#include "Bytes.hpp"
 #include "Entity.hpp"
+#include "Profiler.hpp"
 
+#include <algorithm>
+#include <cstdint>
 #include <map>
 #include <memory>
+#include <span>
+#include <tuple>
 #include <vector>
 
-using EntityVec = std::vector<std::shared_ptr<Entity>>;
-using EntityMap = std::map<std::string, EntityVec>;
-
+// Entities live in fixed-size chunks owned by the manager and are handed out
+// as plain pointers. A slot is recycled once update() has dropped its dead
+// entity from every list, so a pointer held across an update() must be
+// checked against the id it was taken with. Tags are interned as the entries
+// of m_entityMap, which are never erased, and each entity points at its own.
+//
+// Tags that come and go in bulk, bullets and the like, can be given a pool:
+// reserve() preallocates slots and list capacity for that many of them, and
+// addPooled() spawns one without looking its tag up. Dead slots go back on
+// the free list at update() and are the next ones handed out, so while
+// every pool stays within its capacity and the tags without one within a
+// chunk, spawning and clearing away pooled entities never allocates.
 class EntityManager
 {
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+  public:
+    struct Pool
+    {
+        // the tag and its list
+        EntityMap::value_type *entry = nullptr;
+        size_t capacity = 0;
+        // the most of them alive at once after an update()
+        size_t highWater = 0;
+    };
+
+  private:
+    std::vector<std::unique_ptr<Entity[]>> m_chunks;
+    std::vector<Entity *> m_free;
+    size_t m_used = 0;
     EntityVec m_entities;
     EntityVec m_entitiesToAdd;
     EntityMap m_entityMap;
+    std::vector<Pool> m_pools;
     size_t m_totalEntities = 0;
 
     void removeDeadEntities(EntityVec &vec)
     {
         vec.erase(std::remove_if(vec.begin(), vec.end(),
-                            [](const std::shared_ptr<Entity> &e) 
+                            [](const Entity *e) 
                             { 
                                 return !e->isAlive();    
                             }),
                   vec.end());
     }
 
+    Entity *slot(size_t i) const
+    {
+        return &m_chunks[i / CHUNK_SIZE][i % CHUNK_SIZE];
+    }
+
+    Entity *allocate(const std::string &tag, size_t id)
+    {
+        return allocate(&*m_entityMap.try_emplace(tag).first, id);
+    }
+
+    Entity *allocate(EntityMap::value_type *tag, size_t id)
+    {
+        Entity *e = nullptr;
+        if (!m_free.empty())
+        {
+            e = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            if (m_used == m_chunks.size() * CHUNK_SIZE)
+            {
+                m_chunks.push_back(std::make_unique<Entity[]>(CHUNK_SIZE));
+            }
+            e = slot(m_used++);
+        }
+        *e = Entity(tag, id);
+        return e;
+    }
+
+    // releases every slot but keeps the chunks and the interned tags
+    void reset()
+    {
+        m_free.clear();
+        m_used = 0;
+        m_entities.clear();
+        m_entitiesToAdd.clear();
+        for (auto &[tag, vec] : m_entityMap)
+        {
+            vec.clear();
+        }
+    }
+
+    // id, tag, alive flag, then a bit per component present followed by the
+    // bytes of each present component
+    static void saveEntity(ByteWriter &out, const Entity &e)
+    {
+        out.putVarint(e.m_id);
+        out.putString(e.tag());
+        out.put(static_cast<std::uint8_t>(e.m_alive));
+
+        std::uint8_t mask = 0;
+        std::uint8_t bit = 1;
+        std::apply([&](const auto &...c) { ((mask |= c.exists ? bit : 0, bit <<= 1), ...); }, e.m_components);
+        out.put(mask);
+        std::apply([&](const auto &...c) { ((c.exists ? out.put(c) : void()), ...); }, e.m_components);
+    }
+
+    Entity *loadEntity(ByteReader &in)
+    {
+        std::uint64_t id = 0;
+        std::string tag;
+        std::uint8_t alive = 0;
+        std::uint8_t mask = 0;
+        if (!in.getVarint(id) || !in.getString(tag) || !in.get(alive) || !in.get(mask)) return nullptr;
+
+        Entity *e = allocate(tag, static_cast<size_t>(id));
+        e->m_alive = alive != 0;
+        std::uint8_t bit = 1;
+        std::apply([&](auto &...c) { ((mask & bit ? (void)in.get(c) : void(), bit <<= 1), ...); }, e->m_components);
+        return in.ok() ? e : nullptr;
+    }
+
   public:
+    // Everything needed to put the manager back exactly as it was: the used
+    // slots copied wholesale plus the lists of pointers into them. Pointers
+    // are only meaningful to the manager that captured the snapshot, and the
+    // vectors keep their capacity, so capturing into the same Snapshot again
+    // does not allocate once it has seen the peak entity count.
+    struct Snapshot
+    {
+        std::vector<Entity> slots;
+        std::vector<Entity *> free;
+        EntityVec entities;
+        EntityVec toAdd;
+        std::vector<std::pair<const std::string *, EntityVec>> byTag;
+        size_t used = 0;
+        size_t total = 0;
+
+        void reserve(size_t n)
+        {
+            slots.reserve(n);
+            free.reserve(n);
+            entities.reserve(n);
+            toAdd.reserve(n);
+        }
+
+        // heap held, including capacity not in use
+        size_t bytes() const
+        {
+            size_t total = slots.capacity() * sizeof(Entity) +
+                           (free.capacity() + entities.capacity() + toAdd.capacity()) * sizeof(Entity *) +
+                           byTag.capacity() * sizeof(byTag[0]);
+            for (const auto &[tag, list] : byTag)
+            {
+                total += list.capacity() * sizeof(Entity *);
+            }
+            return total;
+        }
+    };
+
     EntityManager() = default;
 
-    void update()
+    // ids handed out so far; the next entity gets this one
+    size_t totalEntities() const
+    {
+        return m_totalEntities;
+    }
+
+    // slots handed out so far, live or waiting for reuse
+    size_t poolSize() const
+    {
+        return m_used;
+    }
+
+    // slots allocated, in use or not
+    size_t slotCapacity() const
+    {
+        return m_chunks.size() * CHUNK_SIZE;
+    }
+
+    // Makes tag a pooled tag with room for capacity live entities and returns
+    // its pool for addPooled(). Every pool shares the slots, with a chunk
+    // over for the tags without one. The slots are not partitioned: tags
+    // without a pool that outgrow that chunk take slots the pools counted on,
+    // and the next spawn past the total allocates a new chunk. Reserving an
+    // existing pool again only ever grows it.
+    size_t reserve(const std::string &tag, size_t capacity)
+    {
+        auto *entry = &*m_entityMap.try_emplace(tag).first;
+        auto pool = std::find_if(m_pools.begin(), m_pools.end(), [&](const Pool &p) { return p.entry == entry; });
+        if (pool == m_pools.end())
+        {
+            pool = m_pools.insert(m_pools.end(), Pool{entry, 0, 0});
+        }
+        pool->capacity = std::max(pool->capacity, capacity);
+        pool->entry->second.reserve(pool->capacity);
+        const size_t index = static_cast<size_t>(pool - m_pools.begin());
+
+        size_t pooled = 0;
+        for (const Pool &p : m_pools)
+        {
+            pooled += p.capacity;
+        }
+        const size_t slots = pooled + CHUNK_SIZE;
+        while (m_chunks.size() * CHUNK_SIZE < slots)
+        {
+            m_chunks.push_back(std::make_unique<Entity[]>(CHUNK_SIZE));
+        }
+        m_free.reserve(slots);
+        m_entities.reserve(slots);
+        m_entitiesToAdd.reserve(pooled);
+        return index;
+    }
+
+    std::span<const Pool> pools() const
+    {
+        return m_pools;
+    }
+
+    void capture(Snapshot &s) const
+    {
+        s.slots.resize(m_used);
+        for (size_t base = 0; base < m_used; base += CHUNK_SIZE)
+        {
+            std::copy_n(m_chunks[base / CHUNK_SIZE].get(), std::min(CHUNK_SIZE, m_used - base), s.slots.data() + base);
+        }
+        s.free = m_free;
+        s.entities = m_entities;
+        s.toAdd = m_entitiesToAdd;
+        s.byTag.resize(m_entityMap.size());
+        size_t i = 0;
+        for (const auto &[tag, vec] : m_entityMap)
+        {
+            s.byTag[i].first = &tag;
+            s.byTag[i].second = vec;
+            i++;
+        }
+        s.used = m_used;
+        s.total = m_totalEntities;
+    }
+
+    // Slots handed out since the capture are simply unused again; chunks are
+    // never freed, so every pointer in the snapshot is still valid.
+    void restore(const Snapshot &s)
+    {
+        for (size_t base = 0; base < s.used; base += CHUNK_SIZE)
+        {
+            std::copy_n(s.slots.data() + base, std::min(CHUNK_SIZE, s.used - base), m_chunks[base / CHUNK_SIZE].get());
+        }
+        m_free = s.free;
+        m_entities = s.entities;
+        m_entitiesToAdd = s.toAdd;
+        for (auto &[tag, vec] : m_entityMap)
+        {
+            auto it = std::find_if(s.byTag.begin(), s.byTag.end(), [&](const auto &t) { return t.first == &tag; });
+            if (it != s.byTag.end())
+            {
+                vec = it->second;
+            }
+            else
+            {
+                vec.clear();
+            }
+        }
+        m_used = s.used;
+        m_totalEntities = s.total;
+    }
+
+    // Writes every entity, including those still waiting to be added, so a
+    // loaded manager carries on exactly where this one was.
+    void save(ByteWriter &out) const
     {
-        // add all entites we want to add
-        for (auto &e : m_entitiesToAdd)
+        out.putVarint(m_totalEntities);
+        out.putVarint(m_entities.size());
+        for (const auto *e : m_entities)
         {
+            saveEntity(out, *e);
+        }
+        out.putVarint(m_entitiesToAdd.size());
+        for (const auto *e : m_entitiesToAdd)
+        {
+            saveEntity(out, *e);
+        }
+    }
+
+    // Replaces the contents with what save() wrote. Returns false, leaving the
+    // manager empty, if the data is truncated or malformed.
+    bool load(ByteReader &in)
+    {
+        reset();
+
+        std::uint64_t total = 0;
+        std::uint64_t count = 0;
+        if (!in.getVarint(total) || !in.getVarint(count)) return false;
+        m_totalEntities = static_cast<size_t>(total);
+
+        for (std::uint64_t i = 0; i < count; i++)
+        {
+            Entity *e = loadEntity(in);
+            if (!e) break;
             m_entities.push_back(e);
-            m_entityMap[e->m_tag].push_back(e);
+            e->m_tag->second.push_back(e);
         }
 
-        m_entitiesToAdd.clear();
+        if (in.getVarint(count))
+        {
+            for (std::uint64_t i = 0; i < count; i++)
+            {
+                Entity *e = loadEntity(in);
+                if (!e) break;
+                m_entitiesToAdd.push_back(e);
+            }
+        }
+
+        if (!in.ok())
+        {
+            reset();
+            return false;
+        }
+        return true;
+    }
+
+    // Bulk path for loaders: replaces the contents with ids.size() entities
+    // in consecutive slots, entity i tagged tags[tagIndex[i]]. The first live
+    // of them go straight into the entity lists and the rest into the add
+    // queue, in order. Components start empty. tagIndex must be in range.
+    void assign(size_t total, std::span<const std::string> tags, std::span<const std::uint64_t> ids,
+                std::span<const std::uint16_t> tagIndex, std::span<const std::uint8_t> alive, size_t live)
+    {
+        reset();
+        const size_t count = ids.size();
+        while (m_chunks.size() * CHUNK_SIZE < count)
+        {
+            m_chunks.push_back(std::make_unique<Entity[]>(CHUNK_SIZE));
+        }
+
+        std::vector<EntityMap::value_type *> interned;
+        interned.reserve(tags.size());
+        for (const auto &tag : tags)
+        {
+            interned.push_back(&*m_entityMap.try_emplace(tag).first);
+        }
+
+        m_entities.reserve(live);
+        m_entitiesToAdd.reserve(count - live);
+        for (size_t i = 0; i < count; i++)
+        {
+            Entity *e = slot(i);
+            *e = Entity(interned[tagIndex[i]], static_cast<size_t>(ids[i]));
+            e->m_alive = alive[i] != 0;
+            if (i < live)
+            {
+                m_entities.push_back(e);
+                e->m_tag->second.push_back(e);
+            }
+            else
+            {
+                m_entitiesToAdd.push_back(e);
+            }
+        }
+        m_used = count;
+        m_totalEntities = total;
+    }
+
+    void update()
+    {
+        {
+            PROFILE_SCOPE("update/add");
+            // add all entites we want to add
+            for (auto &e : m_entitiesToAdd)
+            {
+                m_entities.push_back(e);
+                e->m_tag->second.push_back(e);
+            }
 
+            m_entitiesToAdd.clear();
+        }
+
+        PROFILE_SCOPE("update/remove");
+        for (Entity *e : m_entities)
+        {
+            if (!e->isAlive()) m_free.push_back(e);
+        }
         removeDeadEntities(m_entities);
 
         // remove dead entities from each vector in the entity map
@@ -46,11 +398,24 @@ class EntityManager
         {
             removeDeadEntities(entityVec);
         }
+
+        for (Pool &pool : m_pools)
+        {
+            pool.highWater = std::max(pool.highWater, pool.entry->second.size());
+        }
     }
 
-    std::shared_ptr<Entity> addEntity(const std::string &tag)
+    Entity *addEntity(const std::string &tag)
     {
-        auto e = std::make_shared<Entity>(tag, m_totalEntities++);
+        Entity *e = allocate(tag, m_totalEntities++);
+        m_entitiesToAdd.push_back(e);
+        return e;
+    }
+
+    // addEntity() for a pool's tag, without looking the tag up
+    Entity *addPooled(size_t pool)
+    {
+        Entity *e = allocate(m_pools[pool].entry, m_totalEntities++);
         m_entitiesToAdd.push_back(e);
         return e;
     }
@@ -60,6 +425,12 @@ class EntityManager
         return m_entities;
     }
 
+    // added since the last update()
+    const EntityVec &getPendingEntities() const
+    {
+        return m_entitiesToAdd;
+    }
+
     const EntityVec &getEntities(const std::string &tag) const
     {
         static const EntityVec empty;
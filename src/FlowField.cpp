@@ -0,0 +1,151 @@
+#include "FlowField.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+constexpr int STRAIGHT = 5;
+constexpr int DIAGONAL = 7;
+
+struct Step
+{
+    int dx;
+    int dy;
+    int cost;
+};
+
+constexpr std::array<Step, 8> STEPS = {{{1, 0, STRAIGHT},
+                                        {-1, 0, STRAIGHT},
+                                        {0, 1, STRAIGHT},
+                                        {0, -1, STRAIGHT},
+                                        {1, 1, DIAGONAL},
+                                        {-1, 1, DIAGONAL},
+                                        {1, -1, DIAGONAL},
+                                        {-1, -1, DIAGONAL}}};
+}
+
+void FlowField::resize(const Vec2<float> &bounds, int cellSize)
+{
+    m_cell = std::max(cellSize, 1);
+    m_width = std::max(1, static_cast<int>(std::ceil(bounds.x / static_cast<float>(m_cell))));
+    m_height = std::max(1, static_cast<int>(std::ceil(bounds.y / static_cast<float>(m_cell))));
+    m_distance.assign(static_cast<size_t>(m_width) * static_cast<size_t>(m_height), UNREACHED);
+    m_heading.assign(m_distance.size(), Vec2<float>(0.f, 0.f));
+    m_buckets.assign(DIAGONAL + 1, {});
+    m_targetX = -1;
+    m_targetY = -1;
+}
+
+int FlowField::cellX(float x) const
+{
+    return std::clamp(static_cast<int>(std::floor(x / static_cast<float>(m_cell))), 0, m_width - 1);
+}
+
+int FlowField::cellY(float y) const
+{
+    return std::clamp(static_cast<int>(std::floor(y / static_cast<float>(m_cell))), 0, m_height - 1);
+}
+
+void FlowField::update(const Vec2<float> &target)
+{
+    m_target = target;
+    const int x = cellX(target.x);
+    const int y = cellY(target.y);
+    if (x == m_targetX && y == m_targetY) return;
+
+    m_targetX = x;
+    m_targetY = y;
+    build();
+}
+
+void FlowField::build()
+{
+    m_builds++;
+    std::fill(m_distance.begin(), m_distance.end(), UNREACHED);
+    for (auto &bucket : m_buckets)
+    {
+        bucket.clear();
+    }
+
+    // Dial's algorithm: edge costs are at most DIAGONAL, so a ring of
+    // DIAGONAL + 1 buckets holds every distance still pending
+    const int start = m_targetY * m_width + m_targetX;
+    m_distance[static_cast<size_t>(start)] = 0;
+    m_buckets[0].push_back(start);
+    size_t pending = 1;
+    for (int d = 0; pending > 0; d++)
+    {
+        auto &bucket = m_buckets[static_cast<size_t>(d) % m_buckets.size()];
+        // every step costs at least STRAIGHT, so nothing lands in the
+        // bucket being walked
+        for (size_t i = 0; i < bucket.size(); i++)
+        {
+            const int cell = bucket[i];
+            pending--;
+            if (m_distance[static_cast<size_t>(cell)] != d) continue;
+
+            const int cx = cell % m_width;
+            const int cy = cell / m_width;
+            for (const Step &s : STEPS)
+            {
+                const int nx = cx + s.dx;
+                const int ny = cy + s.dy;
+                if (nx < 0 || ny < 0 || nx >= m_width || ny >= m_height) continue;
+
+                const int next = ny * m_width + nx;
+                const int nd = d + s.cost;
+                if (nd < m_distance[static_cast<size_t>(next)])
+                {
+                    m_distance[static_cast<size_t>(next)] = static_cast<std::uint16_t>(nd);
+                    m_buckets[static_cast<size_t>(nd) % m_buckets.size()].push_back(next);
+                    pending++;
+                }
+            }
+        }
+        bucket.clear();
+    }
+
+    // each cell heads for its nearest neighbour
+    const float diagonal = 1.f / std::sqrt(2.f);
+    for (int cy = 0; cy < m_height; cy++)
+    {
+        for (int cx = 0; cx < m_width; cx++)
+        {
+            const size_t cell = static_cast<size_t>(cy * m_width + cx);
+            std::uint16_t best = m_distance[cell];
+            Vec2<float> heading(0.f, 0.f);
+            for (const Step &s : STEPS)
+            {
+                const int nx = cx + s.dx;
+                const int ny = cy + s.dy;
+                if (nx < 0 || ny < 0 || nx >= m_width || ny >= m_height) continue;
+
+                const std::uint16_t d = m_distance[static_cast<size_t>(ny * m_width + nx)];
+                if (d < best)
+                {
+                    best = d;
+                    const float scale = s.cost == DIAGONAL ? diagonal : 1.f;
+                    heading = Vec2<float>(static_cast<float>(s.dx) * scale, static_cast<float>(s.dy) * scale);
+                }
+            }
+            m_heading[cell] = heading;
+        }
+    }
+}
+
+Vec2<float> FlowField::heading(const Vec2<float> &pos) const
+{
+    if (m_distance.empty()) return {0.f, 0.f};
+
+    const int x = cellX(pos.x);
+    const int y = cellY(pos.y);
+    if (x == m_targetX && y == m_targetY)
+    {
+        Vec2<float> d = m_target - pos;
+        d.normalize();
+        return d;
+    }
+    return m_heading[static_cast<size_t>(y * m_width + x)];
+}
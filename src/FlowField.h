@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Vec2.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// Shortest-path headings toward one target over a grid covering the world,
+// so any number of chasers steer with one lookup each instead of looking at
+// each other or the target. The distances are a Dijkstra pass over the
+// 8-connected grid (5 per straight step, 7 per diagonal) with a bucket
+// queue, redone only when the target enters a different cell.
+class FlowField
+{
+    static constexpr std::uint16_t UNREACHED = 0xFFFF;
+
+    int m_cell = 40;
+    int m_width = 0;
+    int m_height = 0;
+    int m_targetX = -1;
+    int m_targetY = -1;
+    Vec2<float> m_target;
+    std::vector<std::uint16_t> m_distance;
+    std::vector<Vec2<float>> m_heading;
+    std::vector<std::vector<int>> m_buckets;
+    std::uint64_t m_builds = 0;
+
+    int cellX(float x) const;
+    int cellY(float y) const;
+    void build();
+
+  public:
+    // Sizes the grid; the next update rebuilds it.
+    void resize(const Vec2<float> &bounds, int cellSize);
+
+    void update(const Vec2<float> &target);
+
+    // Unit heading toward the target from pos. In the target's own cell it
+    // points straight at the target, and it is zero on top of it.
+    Vec2<float> heading(const Vec2<float> &pos) const;
+
+    int width() const
+    {
+        return m_width;
+    }
+
+    int height() const
+    {
+        return m_height;
+    }
+
+    // how many times the distances have been rebuilt
+    std::uint64_t builds() const
+    {
+        return m_builds;
+    }
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+// Log-linear histogram of durations in microseconds, in the spirit of
+// HdrHistogram: exact below 32 us, then 32 buckets per power of two, so any
+// recorded value is reported within ~3% and recording is a couple of shifts.
+class LatencyHistogram
+{
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr std::uint64_t SUB = 1u << SUB_BITS;
+    static constexpr unsigned MAX_SHIFT = 32;
+    static constexpr size_t BUCKETS = SUB + (MAX_SHIFT + 1) * SUB;
+
+    std::array<std::uint64_t, BUCKETS> m_counts{};
+    std::uint64_t m_total = 0;
+    std::uint64_t m_sum = 0;
+    std::uint64_t m_max = 0;
+
+    static size_t index(std::uint64_t us)
+    {
+        if (us < SUB) return static_cast<size_t>(us);
+
+        unsigned shift = static_cast<unsigned>(std::bit_width(us)) - 1 - SUB_BITS;
+        shift = std::min(shift, MAX_SHIFT);
+        std::uint64_t mantissa = std::min<std::uint64_t>(us >> shift, 2 * SUB - 1);
+        return static_cast<size_t>(SUB + shift * SUB + (mantissa - SUB));
+    }
+
+  public:
+    // Largest value that lands in bucket i.
+    static std::uint64_t upperBound(size_t i)
+    {
+        if (i < SUB) return i;
+
+        std::uint64_t shift = (i - SUB) / SUB;
+        std::uint64_t mantissa = SUB + (i - SUB) % SUB;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    static constexpr size_t bucketCount()
+    {
+        return BUCKETS;
+    }
+
+    void record(std::uint64_t us)
+    {
+        m_counts[index(us)]++;
+        m_total++;
+        m_sum += us;
+        m_max = std::max(m_max, us);
+    }
+
+    // Value at or below which fraction p (0..1) of the samples fall.
+    std::uint64_t percentile(double p) const
+    {
+        if (m_total == 0) return 0;
+
+        auto target = static_cast<std::uint64_t>(p * static_cast<double>(m_total) + 0.5);
+        target = std::clamp<std::uint64_t>(target, 1, m_total);
+        std::uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; i++)
+        {
+            seen += m_counts[i];
+            if (seen >= target) return std::min(upperBound(i), m_max);
+        }
+        return m_max;
+    }
+
+    std::uint64_t count() const { return m_total; }
+    std::uint64_t max() const { return m_max; }
+    std::uint64_t bucket(size_t i) const { return m_counts[i]; }
+    double mean() const { return m_total ? static_cast<double>(m_sum) / static_cast<double>(m_total) : 0.0; }
+
+    void reset()
+    {
+        *this = LatencyHistogram();
+    }
+};
+
+// Frame, simulation and render time histograms plus over-budget counters,
+// with CSV/JSON dumps for comparing runs. frame is the interval between
+// frames; the budget counters use sim + render, the CPU work of the frame,
+// so a frame-rate limiter sleeping in display() doesn't count against them.
+class FrameStats
+{
+  public:
+    static constexpr double BUDGET_60_US = 16666.7;
+    static constexpr double BUDGET_120_US = 8333.3;
+
+    LatencyHistogram frame;
+    LatencyHistogram sim;
+    LatencyHistogram render;
+    std::uint64_t over60 = 0;
+    std::uint64_t over120 = 0;
+
+    void record(std::uint64_t frameUs, std::uint64_t simUs, std::uint64_t renderUs)
+    {
+        frame.record(frameUs);
+        sim.record(simUs);
+        render.record(renderUs);
+        auto workUs = static_cast<double>(simUs + renderUs);
+        if (workUs > BUDGET_60_US) over60++;
+        if (workUs > BUDGET_120_US) over120++;
+    }
+
+    void reset()
+    {
+        frame.reset();
+        sim.reset();
+        render.reset();
+        over60 = 0;
+        over120 = 0;
+    }
+
+    bool writeCsv(const std::string &path) const
+    {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+
+        out << "series,count,mean_ms,p50_ms,p90_ms,p99_ms,p999_ms,max_ms\n";
+        auto row = [&out](const char *name, const LatencyHistogram &h)
+        {
+            out << name << ',' << h.count() << ',' << h.mean() / 1000.0 << ','
+                << h.percentile(0.5) / 1000.0 << ',' << h.percentile(0.9) / 1000.0 << ','
+                << h.percentile(0.99) / 1000.0 << ',' << h.percentile(0.999) / 1000.0 << ','
+                << h.max() / 1000.0 << '\n';
+        };
+        row("frame", frame);
+        row("sim", sim);
+        row("render", render);
+        out << "over_16.6ms," << over60 << "\nover_8.3ms," << over120 << '\n';
+        return true;
+    }
+
+    bool writeJson(const std::string &path) const
+    {
+        std::ofstream out(path);
+        if (!out.is_open()) return false;
+
+        auto series = [&out](const char *name, const LatencyHistogram &h, bool last)
+        {
+            out << "  \"" << name << "\": {\"count\": " << h.count() << ", \"mean_ms\": " << h.mean() / 1000.0
+                << ", \"p50_ms\": " << h.percentile(0.5) / 1000.0 << ", \"p90_ms\": " << h.percentile(0.9) / 1000.0
+                << ", \"p99_ms\": " << h.percentile(0.99) / 1000.0 << ", \"p999_ms\": " << h.percentile(0.999) / 1000.0
+                << ", \"max_ms\": " << h.max() / 1000.0 << ", \"buckets_us\": [";
+            bool first = true;
+            for (size_t i = 0; i < LatencyHistogram::bucketCount(); i++)
+            {
+                if (h.bucket(i) == 0) continue;
+                out << (first ? "" : ", ") << '[' << LatencyHistogram::upperBound(i) << ", " << h.bucket(i) << ']';
+                first = false;
+            }
+            out << "]}" << (last ? "\n" : ",\n");
+        };
+        out << "{\n";
+        series("frame", frame, false);
+        series("sim", sim, false);
+        series("render", render, false);
+        out << "  \"over_16_6ms\": " << over60 << ",\n  \"over_8_3ms\": " << over120 << "\n}\n";
+        return true;
+    }
+};
@@ -1,11 +1,13 @@
 #include "Game.h"
 
 #include <algorithm>
-#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
 #include <iostream>
-#include <random>
 #include <string>
-#include <cstdint>
+#include <thread>
 
 Game::Game(const std::string &config)
     : m_text(m_font, "Defualt", 18)
@@ -15,117 +17,43 @@ Game::Game(const std::string &config)
 
 Game::~Game()
 {
-    if (m_imguiInitialized)
+    if (m_replay.isOpen())
     {
-        ImGui::SFML::Shutdown();
+        m_replay.close(m_world);
     }
-}
-
-void Game::init(const std::string &path)
-{
-    std::string type;
-    int wWidth = 1280;
-    int wHeight = 720;
-    int fps = 60;
-
-    std::string fontPath;
-    int fontSize = 18;
 
-    bool windowCfgRead = false;
-    bool fontCfgRead = false;
-    bool playerCfgRead = false;
-    bool enemyCfgRead = false;
-    bool bulletCfgRead = false;
-
-    std::ifstream inputFile(path);
-    if (!inputFile.is_open())
+    if (m_frameStats.frame.count() > 0)
     {
-        std::cerr << "Error: Could not open the file!\n";
-        return;
+        dumpFrameStats();
     }
 
-    while (inputFile >> type)
+    if (m_imguiInitialized)
     {
-        if (type == "Window")
-        {
-            if (!(inputFile >> wWidth >> wHeight >> fps))
-            {
-                std::cerr << "Error: Malformed Window section in config\n";
-                return;
-            }
-            windowCfgRead = true;
-        }
-        else if (type == "Font")
-        {
-            if (!(inputFile >> fontPath >> fontSize))
-            {
-                std::cerr << "Error: Malformed Font section in config\n";
-                return;
-            }
-            fontCfgRead = true;
-        }
-        else if (type == "Player")
-        {
-            if (!(inputFile >> m_playerConfig.SR >> m_playerConfig.CR >> m_playerConfig.FR >>
-                  m_playerConfig.FG >> m_playerConfig.FB >> m_playerConfig.OR >> m_playerConfig.OG >>
-                  m_playerConfig.OB >> m_playerConfig.OT >> m_playerConfig.V >> m_playerConfig.S))
-            {
-                std::cerr << "Error: Malformed Player section in config\n";
-                return;
-            }
-            playerCfgRead = true;
-        }
-        else if (type == "Enemy")
-        {
-            if (!(inputFile >> m_enemyConfig.SR >> m_enemyConfig.CR >> m_enemyConfig.OR >> m_enemyConfig.OG >>
-                  m_enemyConfig.OB >> m_enemyConfig.OT >> m_enemyConfig.VMIN >> m_enemyConfig.VMAX >>
-                  m_enemyConfig.L >> m_enemyConfig.SI >> m_enemyConfig.SMIN >> m_enemyConfig.SMAX))
-            {
-                std::cerr << "Error: Malformed Enemy section in config\n";
-                return;
-            }
-            enemyCfgRead = true;
-        }
-        else if (type == "Bullet")
-        {
-            if (!(inputFile >> m_bulletConfig.SR >> m_bulletConfig.CR >> m_bulletConfig.FR >>
-                  m_bulletConfig.FG >> m_bulletConfig.FB >> m_bulletConfig.OR >> m_bulletConfig.OG >>
-                  m_bulletConfig.OB >> m_bulletConfig.OT >> m_bulletConfig.V >> m_bulletConfig.L >>
-                  m_bulletConfig.S))
-            {
-                std::cerr << "Error: Malformed Bullet section in config\n";
-                return;
-            }
-            bulletCfgRead = true;
-        }
-        else
-        {
-            std::cerr << "Warning: Unknown config section '" << type << "'\n";
-            std::string discard;
-            std::getline(inputFile, discard);
-        }
+        ImGui::SFML::Shutdown();
     }
+}
 
-    if (!(windowCfgRead && fontCfgRead && playerCfgRead && enemyCfgRead && bulletCfgRead))
+void Game::init(const std::string &path)
+{
+    if (!loadConfig(path, m_config))
     {
-        std::cerr << "Error: Missing required config sections\n";
         return;
     }
 
-    if (!m_font.openFromFile(fontPath))
+    if (!m_font.openFromFile(m_config.font.F))
     {
-        std::cerr << "Error: Could not load font at " << fontPath << "\n";
+        std::cerr << "Error: Could not load font at " << m_config.font.F << "\n";
         return;
     }
     m_text.setFont(m_font);
     m_text.setString("Default");
-    m_text.setCharacterSize(static_cast<unsigned int>(fontSize));
+    m_text.setCharacterSize(static_cast<unsigned int>(m_config.font.S));
 
     m_window.create(
-        sf::VideoMode({static_cast<unsigned int>(wWidth), static_cast<unsigned int>(wHeight)}),
+        sf::VideoMode({static_cast<unsigned int>(m_config.window.W), static_cast<unsigned int>(m_config.window.H)}),
         "Geometry Wars");
     m_window.setKeyRepeatEnabled(false);
-    m_window.setFramerateLimit(fps);
+    m_window.setFramerateLimit(m_config.window.FPS);
 
     if (!ImGui::SFML::Init(m_window))
     {
@@ -135,13 +63,27 @@ void Game::init(const std::string &path)
     }
 
     m_imguiInitialized = true;
+    m_world.init(m_config);
+    m_special = static_cast<World::SpecialWeapon>(m_config.special.WEAPON);
+    if (m_config.physics.ENABLED && std::thread::hardware_concurrency() > 1)
+    {
+        m_workers = std::make_unique<ThreadPool>();
+        m_world.setThreadPool(m_workers.get());
+    }
+    if (m_config.deterministic.ENABLED)
+    {
+        std::cout << "Deterministic mode, seed " << m_world.seed() << "\n";
+    }
+    if (m_config.net.HOST != "-")
+    {
+        m_online = m_net.connect(m_config.net.HOST, static_cast<std::uint16_t>(m_config.net.PORT));
+        if (m_online)
+        {
+            std::cout << "Connecting to " << m_config.net.HOST << ":" << m_config.net.PORT << "\n";
+        }
+    }
+    setRewindEnabled(m_config.rewind.ENABLED != 0);
     m_configLoaded = true;
-    spawnPlayer();
-}
-
-std::shared_ptr<Entity> Game::player()
-{
-    return m_entities.getEntities("player").back();
 }
 
 void Game::run()
@@ -152,380 +94,752 @@ void Game::run()
         return;
     }
 
+    using Clock = std::chrono::steady_clock;
+    auto us = [](Clock::duration d)
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+    };
+
     while (m_window.isOpen())
     {
         sf::Time dtTime = m_deltaClock.restart();
         float dt = dtTime.asSeconds();
-        m_entities.update();
-        ImGui::SFML::Update(m_window, dtTime);
-
-        if (m_systems.input) sUserInput();
-        if (m_systems.spawner) sEnemySpawner();
-        if (m_systems.movement) sMovement(dt);
-        if (m_systems.lifespan) sLifespan();
-        if (m_systems.collision) sCollision();
-        sGUI();
-        if (m_systems.render) sRender();
-    
-        m_currentFrame++;
-    }
-}
+        auto frameStart = Clock::now();
+        PROFILE_FRAME_BEGIN();
 
-void Game::spawnPlayer()
-{
-    auto size = m_window.getSize();
-    float spawnX = size.x * 0.5;
-    float spawnY = size.y * 0.5;
-    float angVel = 180.f;
-
-    auto e = m_entities.addEntity("player");
-    e->add<CTransform>(Vec2<float>(spawnX, spawnY), Vec2<float>(0.f, 0.f), 0.0f, angVel);
-    e->add<CShape>(m_playerConfig.SR, m_playerConfig.V,
-                   sf::Color(m_playerConfig.FR, m_playerConfig.FG, m_playerConfig.FB),
-                   sf::Color(m_playerConfig.OR, m_playerConfig.OG, m_playerConfig.OB),
-                   m_playerConfig.OT);
-    e->add<CCollision>(m_playerConfig.CR);
-    e->add<CInput>();
-    e->add<CScore>();
-}
+        const float guiRate = m_config.gui.RATE;
+        m_guiFrame = m_showGui && (guiRate <= 0.f || m_guiClock.getElapsedTime().asSeconds() >= 1.f / guiRate);
+        if (m_guiFrame)
+        {
+            PROFILE_SCOPE("imgui update");
+            ImGui::SFML::Update(m_window, m_guiClock.restart());
+        }
 
-void Game::spawnEnemy() 
-{
-    int rand_pts = randInt(m_enemyConfig.VMIN, m_enemyConfig.VMAX);
+        auto simStart = Clock::now();
+        if (m_systems.input)
+        {
+            PROFILE_SCOPE("input");
+            sUserInput();
+        }
 
-    auto size = m_window.getSize();
-    float x = randFloat(m_enemyConfig.SR, size.x - m_enemyConfig.SR);
-    float y = randFloat(m_enemyConfig.SR, size.y - m_enemyConfig.SR);
-    Vec2<float> pos(x, y);
+        auto wrap = [&]([[maybe_unused]] World::System system, auto &&fn)
+        {
+            PROFILE_SCOPE_NAMED(World::systemName(system));
+            if (!m_perfEnabled)
+            {
+                fn();
+                return;
+            }
 
-    float vx = randFloat(m_enemyConfig.SMIN, m_enemyConfig.SMAX);
-    float vy = randFloat(m_enemyConfig.SMIN, m_enemyConfig.SMAX);
-    Vec2<float> velocity(vx, vy);
+            auto &sum = m_perfSum[static_cast<size_t>(system)];
+            PerfSample before = m_perf.read();
+            auto start = Clock::now();
+            fn();
+            sum.ns += static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            sum.counters += m_perf.read() - before;
+        };
 
-    float angVel = randFloat(-180.f, 180.f);
-    if (std::abs(angVel) < 30.f)
-        angVel = (angVel < 0 ? -30.f : 30.f);
+        if (m_online)
+        {
+            PROFILE_SCOPE("net");
+            m_net.receive();
+            m_net.sendInput();
+            m_net.interpolate(dt * static_cast<float>(m_config.window.FPS), m_world);
+        }
+        else if (m_paused)
+        {
+            m_tickAccumulator = 0.f;
+        }
+        else if (m_config.deterministic.ENABLED)
+        {
+            // fixed ticks, as many as the elapsed time covers; a long stall
+            // drops the backlog rather than spiralling
+            const float tick = 1.f / static_cast<float>(m_config.window.FPS);
+            m_tickAccumulator += dt;
+            int ticks = 0;
+            for (; m_tickAccumulator >= tick && ticks < MAX_TICKS_PER_FRAME; ticks++)
+            {
+                m_replay.record(m_world);
+                m_world.step(tick, wrap);
+                captureRewind();
+                m_tickAccumulator -= tick;
+            }
+            if (ticks == MAX_TICKS_PER_FRAME)
+            {
+                m_tickAccumulator = 0.f;
+            }
+        }
+        else
+        {
+            m_world.step(dt, wrap);
+            captureRewind();
+        }
+        auto simEnd = Clock::now();
 
-    std::uniform_int_distribution<int> col(1, 255);
-    sf::Color randomFill(col(m_rng), col(m_rng), col(m_rng));
+        if (m_perfEnabled && ++m_perfFrames == PERF_WINDOW)
+        {
+            m_perfShown = m_perfSum;
+            m_perfSum = {};
+            m_perfFrames = 0;
+        }
 
-    auto e = m_entities.addEntity("enemy");
-    e->add<CTransform>(pos, velocity, 0.0f, angVel);
-    e->add<CShape>(m_enemyConfig.SR, rand_pts, randomFill,
-                   sf::Color(m_enemyConfig.OR, m_enemyConfig.OG, m_enemyConfig.OB),
-                   m_enemyConfig.OT);
-    e->add<CCollision>(m_enemyConfig.CR);
+        if (m_guiFrame)
+        {
+            PROFILE_SCOPE("gui");
+            sGUI();
+        }
 
-    m_lastEnemySpawnTime = m_currentFrame;
-}
+        if (m_systems.render)
+        {
+            PROFILE_SCOPE("render");
+            sRender();
+        }
+        else if (m_guiFrame)
+        {
+            ImGui::EndFrame();
+        }
+        auto renderEnd = Clock::now();
 
-void Game::spawnSmallEnemies(std::shared_ptr<Entity> e)
-{
-    Vec2<float> spawnLocation = e->get<CTransform>().pos;
-    float angVel = randFloat(-180.f, 180.f);
-    if (std::abs(angVel) < 30.f)
-        angVel = (angVel < 0 ? -30.f : 30.f);
-
-    auto parentFillCol = e->get<CShape>().circle.getFillColor();
-    auto parentOutlineCol = e->get<CShape>().circle.getOutlineColor();
-    // spawn a number of small enemies equal to the vertices of the original
-    int parentPointCount = e->get<CShape>().circle.getPointCount();
-    
-    for (int i = 0; i < parentPointCount; i++)
-    {
-        float vx = randFloat(m_enemyConfig.SMIN, m_enemyConfig.SMAX);
-        float vy = randFloat(m_enemyConfig.SMIN, m_enemyConfig.SMAX);
-        Vec2<float> velocity(vx, vy);
-        
-        auto s = m_entities.addEntity("smallEnemy");
-        s->add<CTransform>(spawnLocation, velocity, 0.0f, angVel);
-        s->add<CShape>(m_enemyConfig.SR / 2, parentPointCount,
-             parentFillCol,
-             parentOutlineCol,
-             m_enemyConfig.OT);
-        s->add<CCollision>(m_enemyConfig.CR / 2);
-        s->add<CLifespan>(m_enemyConfig.L);
+        // display() is where the frame-rate limiter sleeps, so it stays out
+        // of the render time
+        if (m_systems.render && m_window.isOpen())
+        {
+            PROFILE_SCOPE("display");
+            m_window.display();
+        }
+
+        m_frameStats.record(static_cast<std::uint64_t>(dtTime.asMicroseconds()), us(simEnd - simStart),
+                            us(simStart - frameStart) + us(renderEnd - simEnd));
+
+#ifdef ARCHANGEL_PROFILE
+        if (TraceRecorder::recording())
+        {
+            for (const auto &[tag, vec] : m_world.entities().getEntityMap())
+            {
+                TraceRecorder::instance().counter("entities", tag.c_str(), static_cast<double>(vec.size()));
+            }
+            TraceRecorder::instance().counter("particles", "live", static_cast<double>(m_world.particles().size()));
+        }
+#endif
+        PROFILE_FRAME_END();
     }
 }
 
-void Game::spawnBullet(std::shared_ptr<Entity> entity, const Vec2<float> &target)
+void Game::sGUI()
 {
-    Vec2<float> dir = target - entity->get<CTransform>().pos;
-    dir.normalize();
-    float speed = m_bulletConfig.S;
-    Vec2<float> velocity = dir * speed;
-
-    auto spawnPos = entity->get<CTransform>().pos;
-
-    auto b = m_entities.addEntity("bullet");
-    b->add<CTransform>(spawnPos, velocity, 0.0f, 0.0f);
-    b->add<CShape>(m_bulletConfig.SR, m_bulletConfig.V,
-                sf::Color(m_bulletConfig.FR, m_bulletConfig.FG, m_bulletConfig.FB),
-                sf::Color(m_bulletConfig.OR, m_bulletConfig.OG, m_bulletConfig.OB),
-                m_bulletConfig.OT);
-    b->add<CCollision>(m_bulletConfig.CR);
-    b->add<CLifespan>(m_bulletConfig.L);
-}
+    ImGui::Begin("Geometry Wars");
+    if (ImGui::BeginTabBar("Geometry Wars TabBar"))
+    {
+        if (ImGui::BeginTabItem("Systems"))
+        {
+            ImGui::Checkbox("User Input", &m_systems.input);
+            ImGui::Checkbox("Enemy Spawner", &m_world.systems.spawner);
+            ImGui::Checkbox("Movement", &m_world.systems.movement);
+            ImGui::Checkbox("Lifespan", &m_world.systems.lifespan);
+            ImGui::Checkbox("Collision", &m_world.systems.collision);
+            ImGui::Checkbox("Particles", &m_world.systems.particles);
+            if (m_config.physics.ENABLED)
+            {
+                ImGui::SameLine();
+                ImGui::Text("Enemy contacts: %llu", static_cast<unsigned long long>(m_world.contacts().contacts()));
+            }
+            ImGui::Checkbox("Render", &m_systems.render);
+            ImGui::Text("Particles: %zu / %zu", m_world.particles().size(), m_world.particles().capacity());
+            const EntityManager &entities = m_world.entities();
+            ImGui::Text("Entity slots: %zu / %zu", entities.poolSize(), entities.slotCapacity());
+            for (const auto &pool : entities.pools())
+            {
+                ImGui::SameLine();
+                ImGui::Text("| %s %zu / %zu, peak %zu", pool.entry->first.c_str(), pool.entry->second.size(),
+                            pool.capacity, pool.highWater);
+            }
+            ImGui::Text("Right click: %s (Q switches)", World::specialWeaponName(m_special));
+            if (m_config.deterministic.ENABLED)
+            {
+                ImGui::Text("Deterministic: seed %llu, tick %d, hash %016llx",
+                            static_cast<unsigned long long>(m_world.seed()), m_world.currentFrame(),
+                            static_cast<unsigned long long>(m_world.hash()));
+                ImGui::TextUnformatted(m_replay.isOpen() ? "Recording replay.bin (F5 stops)" : "F5 records a replay");
+            }
 
-void Game::spawnSpecialWeapon(std::shared_ptr<Entity> entity)
-{
-    // TODO: implement special weapon
-}
+            if (m_online)
+            {
+                ImGui::Text("Online: %s:%d, %llu snapshots (%llu dropped), %.1f MB received, %.1f ticks behind",
+                            m_config.net.HOST.c_str(), m_config.net.PORT,
+                            static_cast<unsigned long long>(m_net.snapshotsReceived()),
+                            static_cast<unsigned long long>(m_net.snapshotsDropped()),
+                            static_cast<double>(m_net.bytesReceived()) / (1024.0 * 1024.0), m_net.renderDelay());
+            }
 
-void Game::sMovement(float dt)
-{
-    auto &pTransform = player()->get<CTransform>();
-    auto &pInput = player()->get<CInput>();
+            ImGui::Separator();
+            bool paused = m_paused;
+            if (ImGui::Checkbox("Paused (P)", &paused))
+            {
+                setPaused(paused);
+            }
+            if (!m_online)
+            {
+                bool rewinding = m_rewindEnabled;
+                ImGui::SameLine();
+                if (ImGui::Checkbox("Rewind", &rewinding))
+                {
+                    setRewindEnabled(rewinding);
+                }
+            }
+            if (m_rewindEnabled)
+            {
+                ImGui::SameLine();
+                ImGui::Text("%zu / %zu snapshots every %d ticks, %.1f MB, capture %.1f us, restore %.1f us",
+                            m_rewind.size(), m_rewind.capacity(), std::max(m_config.rewind.EVERY, 1),
+                            static_cast<double>(m_rewind.bytes()) / (1024.0 * 1024.0), m_captureUs, m_restoreUs);
+            }
+            if (m_rewindEnabled && m_paused && m_rewind.size() > 1)
+            {
+                int back = m_rewindBack;
+                ImGui::SetNextItemWidth(240.f);
+                if (ImGui::SliderInt("Snapshots back", &back, 0, static_cast<int>(m_rewind.size()) - 1))
+                {
+                    rewind(back);
+                }
+            }
+            ImGui::SetNextItemWidth(120.f);
+            ImGui::SliderFloat("GUI rate (Hz, 0 = every frame)", &m_config.gui.RATE, 0.f, 60.f, "%.0f");
+            ImGui::TextUnformatted("F1 hides the GUI, F6 dumps the world to world.agw");
 
-    Vec2<float> dir(0.0f, 0.0f);
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Profiler"))
+        {
+            guiProfiler();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Frame Times"))
+        {
+            guiFrameTimes();
+            ImGui::EndTabItem();
+        }
+        if (ImGui::BeginTabItem("Entity Manager"))
+        {
+            guiEntities();
+            ImGui::EndTabItem();
+        }
 
-    if (pInput.up) dir.y -= 1.f;
-    if (pInput.down) dir.y += 1.f;
-    if (pInput.right) dir.x += 1.f;
-    if (pInput.left) dir.x -= 1.f;
+        ImGui::EndTabBar();
+    }
+    
+    ImGui::End();
+}
 
-    if (dir.x != 0.f || dir.y != 0.f)
+void Game::guiEntities()
+{
+    auto &ins = m_inspector;
+    const auto &entityMap = m_world.entities().getEntityMap();
+
+    ImGui::SetNextItemWidth(120.f);
+    if (ImGui::BeginCombo("Tag", ins.tag.empty() ? "all" : ins.tag.c_str()))
     {
-        dir.normalize();
-        pTransform.velocity = dir * m_playerConfig.S;
+        if (ImGui::Selectable("all", ins.tag.empty()))
+        {
+            ins.tag.clear();
+            ins.dirty = true;
+        }
+        for (const auto &[tag, vec] : entityMap)
+        {
+            if (ImGui::Selectable(tag.c_str(), ins.tag == tag))
+            {
+                ins.tag = tag;
+                ins.dirty = true;
+            }
+        }
+        ImGui::EndCombo();
     }
-    else 
+    ImGui::SameLine();
+    if (ins.idFilter.Draw("ID filter", 120.f))
     {
-        pTransform.velocity = {0.f, 0.f};
+        ins.dirty = true;
     }
-    
-    for (auto &e : m_entities.getEntities())
+    ImGui::SameLine();
+    ImGui::Checkbox("Auto refresh", &ins.autoRefresh);
+    ImGui::SameLine();
+    if (ImGui::Button("Refresh"))
     {
-        if (!e->has<CTransform>()) continue;
-        auto &t = e->get<CTransform>();
-        t.pos += t.velocity * dt;
-        t.angle += t.angVel * dt;
+        ins.dirty = true;
     }
-}
 
-void Game::sLifespan()
-{
-    for (auto &e : m_entities.getEntities())
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_ScrollY |
+                                  ImGuiTableFlags_Sortable | ImGuiTableFlags_Resizable;
+    const float detailWidth = 220.f;
+    ImVec2 tableSize(ImGui::GetContentRegionAvail().x - detailWidth, 300.f);
+    if (ImGui::BeginTable("Entities", 7, flags, tableSize))
     {
-        if (!e->has<CLifespan>()) continue;
-        
-        auto &life = e->get<CLifespan>();
-  
-        if (life.remaining > 0)
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("##color", ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthFixed, 18.f);
+        ImGui::TableSetupColumn("ID", ImGuiTableColumnFlags_DefaultSort, 0.f, 0);
+        ImGui::TableSetupColumn("Tag", 0, 0.f, 1);
+        ImGui::TableSetupColumn("X", 0, 0.f, 2);
+        ImGui::TableSetupColumn("Y", 0, 0.f, 3);
+        ImGui::TableSetupColumn("Life", 0, 0.f, 4);
+        ImGui::TableSetupColumn("##destroy", ImGuiTableColumnFlags_NoSort | ImGuiTableColumnFlags_WidthFixed, 20.f);
+        ImGui::TableHeadersRow();
+
+        if (ImGuiTableSortSpecs *sort = ImGui::TableGetSortSpecs(); sort && sort->SpecsDirty)
         {
-            life.remaining -= 1;
+            if (sort->SpecsCount > 0)
+            {
+                ins.sortColumn = sort->Specs[0].ColumnUserID;
+                ins.sortAscending = sort->Specs[0].SortDirection == ImGuiSortDirection_Ascending;
+            }
+            sort->SpecsDirty = false;
+            ins.dirty = true;
         }
 
-        // Fade alpha 1:1 with remaining lifespan.
-        if (e->has<CShape>())
+        if (ins.dirty || (ins.autoRefresh && ImGui::GetTime() - ins.lastBuild > 0.25))
         {
-            auto &circle = e->get<CShape>().circle;
-            const float ratio = std::clamp(life.remaining / static_cast<float>(life.lifespan), 0.f, 1.f);
-            auto applyAlpha = [ratio](sf::Color c)
-            {
-                c.a = static_cast<std::uint8_t>(ratio * 255.0f);
-                return c;
-            };
-            circle.setFillColor(applyAlpha(circle.getFillColor()));
-            circle.setOutlineColor(applyAlpha(circle.getOutlineColor()));
+            buildEntityRows();
         }
 
-        if (life.remaining <= 0)
+        ImGuiListClipper clipper;
+        clipper.Begin(static_cast<int>(ins.rows.size()));
+        while (clipper.Step())
         {
-            e->destroy();
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+            {
+                const EntityRow &r = ins.rows[static_cast<size_t>(row)];
+                Entity *e = r.get();
+                ImGui::PushID(row);
+                ImGui::TableNextRow();
+
+                ImGui::TableNextColumn();
+                sf::Color preview = e && e->has<CShape>() ? e->get<CShape>().fill : sf::Color(128, 128, 128);
+                ImVec4 imguiCol(preview.r / 255.f, preview.g / 255.f, preview.b / 255.f, preview.a / 255.f);
+                ImGui::ColorButton("##color", imguiCol, ImGuiColorEditFlags_NoTooltip, ImVec2(14, 14));
+
+                ImGui::TableNextColumn();
+                char label[32];
+                std::snprintf(label, sizeof(label), "%zu%s", r.id, e && e->isAlive() ? "" : " (dead)");
+                if (ImGui::Selectable(label, ins.selected.entity == r.entity && ins.selected.id == r.id,
+                                      ImGuiSelectableFlags_SpanAllColumns | ImGuiSelectableFlags_AllowOverlap))
+                {
+                    ins.selected = r;
+                }
+                if (!e)
+                {
+                    ImGui::PopID();
+                    continue;
+                }
+
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(e->tag().c_str());
+                if (e->has<CTransform>())
+                {
+                    const auto &t = e->get<CTransform>();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.0f", t.pos.x);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.0f", t.pos.y);
+                }
+                else
+                {
+                    ImGui::TableNextColumn();
+                    ImGui::TableNextColumn();
+                }
+                ImGui::TableNextColumn();
+                if (e->has<CLifespan>())
+                {
+                    ImGui::Text("%d", e->get<CLifespan>().remaining);
+                }
+
+                ImGui::TableNextColumn();
+                if (ImGui::SmallButton("D"))
+                {
+                    e->destroy();
+                }
+                ImGui::PopID();
+            }
         }
+        ImGui::EndTable();
+    }
+
+    ImGui::SameLine();
+    ImGui::BeginChild("EntityDetails", ImVec2(detailWidth, 300.f), ImGuiChildFlags_Borders);
+    if (Entity *selected = ins.selected.get())
+    {
+        guiEntityDetails(*selected);
     }
+    else
+    {
+        ImGui::TextUnformatted("Select an entity");
+    }
+    ImGui::EndChild();
+
+    ImGui::Text("Showing %zu of %zu entities", ins.rows.size(), m_world.entities().getEntities().size());
 }
 
-void Game::sCollision()
+void Game::buildEntityRows()
 {
-    int &pScore = player()->get<CScore>().score;
-    auto size = m_window.getSize();
-    int bigEnemyPoints = 25;
-    int smallEnemyPoints = 50;
-    
-    for (auto b : m_entities.getEntities("bullet"))
-    { 
-        for (auto e : m_entities.getEntities("enemy"))
-        {
-           if (!b->has<CCollision>() || !e->has<CCollision>()) continue;
-
-           if (isColliding(b, e))
-           {
-                b->destroy();
-                e->destroy();
-                spawnSmallEnemies(e);
-                pScore += bigEnemyPoints;
-           }
-        }
+    auto &ins = m_inspector;
+    const EntityVec &source = ins.tag.empty() ? m_world.entities().getEntities() : m_world.entities().getEntities(ins.tag);
 
-        for (auto e : m_entities.getEntities("smallEnemy"))
+    ins.rows.clear();
+    char id[24];
+    for (Entity *e : source)
+    {
+        if (ins.idFilter.IsActive())
         {
-           if (!b->has<CCollision>() || !e->has<CCollision>()) continue;
-           
-           if (isColliding(b, e))
-           {
-                b->destroy();
-                e->destroy();
-                pScore += smallEnemyPoints;
-           }
+            std::snprintf(id, sizeof(id), "%zu", e->id());
+            if (!ins.idFilter.PassFilter(id)) continue;
         }
+        ins.rows.push_back({e, e->id()});
     }
 
-    // Player collisions
-    for (auto e :m_entities.getEntities("enemy"))
+    auto key = [column = ins.sortColumn](Entity *e) -> float
     {
-        if (!e->has<CCollision>()) continue;
-
-        if (isColliding(player(), e))
+        switch (column)
         {
-            respawnPlayer(player());
+            case 2: return e->has<CTransform>() ? e->get<CTransform>().pos.x : 0.f;
+            case 3: return e->has<CTransform>() ? e->get<CTransform>().pos.y : 0.f;
+            case 4: return e->has<CLifespan>() ? static_cast<float>(e->get<CLifespan>().remaining) : 0.f;
+            default: return 0.f;
         }
-    }
-
-    for (auto e :m_entities.getEntities("smallEnemy"))
+    };
+    auto less = [&](const EntityRow &ra, const EntityRow &rb)
     {
-        if (!e->has<CCollision>()) continue;
-
-        if (isColliding(player(), e))
+        Entity *a = ra.entity;
+        Entity *b = rb.entity;
+        if (ins.sortColumn == 1 && a->tag() != b->tag()) return a->tag() < b->tag();
+        if (ins.sortColumn >= 2)
         {
-            respawnPlayer(player());
+            float ka = key(a);
+            float kb = key(b);
+            if (ka != kb) return ka < kb;
         }
+        return a->id() < b->id();
+    };
+    if (ins.sortAscending)
+    {
+        std::sort(ins.rows.begin(), ins.rows.end(), less);
+    }
+    else
+    {
+        std::sort(ins.rows.begin(), ins.rows.end(), [&](const auto &a, const auto &b) { return less(b, a); });
     }
 
-    // Collisions with walls
-    float w = static_cast<float>(size.x);
-    float h = static_cast<float>(size.y);
+    ins.dirty = false;
+    ins.lastBuild = ImGui::GetTime();
+}
+
+void Game::guiEntityDetails(Entity &e)
+{
+    ImGui::Text("%s %zu%s", e.tag().c_str(), e.id(), e.isAlive() ? "" : " (dead)");
+    ImGui::Separator();
 
-    for (auto e : m_entities.getEntities())
+    if (e.has<CTransform>())
+    {
+        auto &t = e.get<CTransform>();
+        ImGui::Text("pos   %.1f, %.1f", t.pos.x, t.pos.y);
+        ImGui::Text("vel   %.2f, %.2f", t.velocity.x, t.velocity.y);
+        ImGui::Text("angle %.1f (%.1f/frame)", t.angle, t.angVel);
+    }
+    if (e.has<CShape>())
+    {
+        auto &shape = e.get<CShape>();
+        ImGui::Text("shape r %.1f, %zu points", shape.radius, shape.points);
+    }
+    if (e.has<CCollision>())
+    {
+        ImGui::Text("collision r %.1f", e.get<CCollision>().radius);
+    }
+    if (e.has<CLifespan>())
     {
-        if (!e->has<CCollision>() || !e->has<CTransform>()) continue;
+        auto &life = e.get<CLifespan>();
+        ImGui::Text("lifespan %d / %d", life.remaining, life.lifespan);
+    }
+    if (e.has<CScore>())
+    {
+        ImGui::Text("score %d", e.get<CScore>().score);
+    }
+    if (e.has<CInput>())
+    {
+        auto &input = e.get<CInput>();
+        ImGui::Text("input %s%s%s%s", input.up ? "U" : "-", input.left ? "L" : "-", input.down ? "D" : "-", input.right ? "R" : "-");
+    }
 
-        auto &t = e->get<CTransform>();
-        auto &c = e->get<CCollision>();
-        float r = c.radius;
+    if (e.isAlive() && ImGui::Button("Destroy"))
+    {
+        e.destroy();
+    }
+}
+
+void Game::guiProfiler()
+{
+    const auto &entityMap = m_world.entities().getEntityMap();
+    ImGui::Text("Entities: %zu", m_world.entities().getEntities().size());
+    for (const auto &[tag, vec] : entityMap)
+    {
+        ImGui::SameLine();
+        ImGui::Text("  %s: %zu", tag.c_str(), vec.size());
+    }
 
-        bool bouncedX = false;
-        bool bouncedY = false;
+#ifdef ARCHANGEL_PROFILE
+    const auto &profiler = Profiler::instance();
+    const size_t window = 240;
+    const size_t frames = std::min(profiler.frameCount(), window);
+    const float budgetMs = 1000.f / static_cast<float>(m_config.window.FPS);
 
-        // Left wall
-        if (t.pos.x - r < 0.f)
-        {
-            t.pos.x = r;
-            bouncedX = true;
-        }
-        else if (t.pos.x + r > w)
+    auto zoneColor = [](std::uint16_t zone)
+    {
+        return static_cast<ImU32>(ImColor::HSV(std::fmod(static_cast<float>(zone) * 0.137f, 1.f), 0.6f, 0.9f));
+    };
+
+    // rolling stacked graph of top-level zones, newest frame on the right
+    ImVec2 size(ImGui::GetContentRegionAvail().x, 120.f);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::InvisibleButton("##timeline", size);
+    ImDrawList *draw = ImGui::GetWindowDrawList();
+    draw->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), IM_COL32(20, 20, 20, 255));
+
+    const float scale = size.y / (budgetMs * 2.f);
+    const float barWidth = size.x / static_cast<float>(window);
+    for (size_t ago = 0; ago < frames; ago++)
+    {
+        const auto &f = profiler.frame(ago);
+        float x = origin.x + size.x - static_cast<float>(ago + 1) * barWidth;
+        float y = origin.y + size.y;
+        for (std::uint32_t i = 0; i < f.count; i++)
         {
-            t.pos.x = w - r;
-            bouncedX = true;
+            const auto &z = f.zones[i];
+            if (z.depth != 0) continue;
+
+            float h = static_cast<float>(z.durationNs) * 1e-6f * scale;
+            draw->AddRectFilled(ImVec2(x, std::max(y - h, origin.y)), ImVec2(x + barWidth, y), zoneColor(z.zone));
+            y -= h;
         }
+    }
+    float budgetY = origin.y + size.y - budgetMs * scale;
+    draw->AddLine(ImVec2(origin.x, budgetY), ImVec2(origin.x + size.x, budgetY), IM_COL32(255, 80, 80, 200));
+    ImGui::Text("Frame budget %.1f ms (red line), graph top %.1f ms", budgetMs, budgetMs * 2.f);
 
-        // Top wall
-        if (t.pos.y - r < 0.f)
+    auto &trace = TraceRecorder::instance();
+    if (TraceRecorder::recording())
+    {
+        if (ImGui::Button("Stop trace (F9)")) toggleTrace();
+        ImGui::SameLine();
+        ImGui::Text("Recording to %s: %llu events, %llu dropped", trace.path().c_str(),
+                    static_cast<unsigned long long>(trace.eventsWritten()),
+                    static_cast<unsigned long long>(trace.eventsDropped()));
+    }
+    else if (trace.writing())
+    {
+        ImGui::Text("Flushing %s...", trace.path().c_str());
+    }
+    else
+    {
+        if (ImGui::Button("Record 10 s trace (F9)")) toggleTrace();
+        if (!trace.path().empty())
         {
-            t.pos.y = r;
-            bouncedY = true;
+            ImGui::SameLine();
+            ImGui::Text("Last: %s, %llu events, %llu dropped", trace.path().c_str(),
+                        static_cast<unsigned long long>(trace.eventsWritten()),
+                        static_cast<unsigned long long>(trace.eventsDropped()));
         }
-        else if (t.pos.y + r > h)
+    }
+
+    ImGui::Text("No-alloc violations: %llu", static_cast<unsigned long long>(AllocTracker::violations()));
+    if (AllocTracker::lastViolation())
+    {
+        ImGui::SameLine();
+        ImGui::Text("(last in %s)", AllocTracker::lastViolation());
+    }
+
+    if (ImGui::BeginTable("Zones", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+    {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Last ms");
+        ImGui::TableSetupColumn("Min ms");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableSetupColumn("Allocs/frame");
+        ImGui::TableSetupColumn("KB/frame");
+        ImGui::TableHeadersRow();
+
+        for (size_t zone = 0; zone < Profiler::zoneCount(); zone++)
         {
-            t.pos.y = h - r;
-            bouncedY = true;
+            auto id = static_cast<std::uint16_t>(zone);
+            ZoneStats stats = profiler.stats(id, window, m_profileScratch);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::ColorButton("##zone", ImColor(zoneColor(id)), ImGuiColorEditFlags_NoTooltip, ImVec2(10, 10));
+            ImGui::SameLine();
+            ImGui::TextUnformatted(Profiler::zoneName(id));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.lastMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.minMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.avgMs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.p99Ms);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", stats.allocs);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", stats.allocBytes / 1024.f);
         }
-
-        if (bouncedX) { t.velocity.x *= -1.f; }
-        if (bouncedY) { t.velocity.y *= -1.f; }
+        ImGui::EndTable();
     }
+#else
+    ImGui::TextUnformatted("Profiler compiled out; build with PROFILE=1 to enable it.");
+#endif
+
+    guiPerfCounters();
 }
 
-void Game::sEnemySpawner()
+void Game::guiPerfCounters()
 {
-    bool spawnNow = m_currentFrame % m_enemyConfig.SI == 0;
-
-    if (spawnNow)
+    if (!ImGui::CollapsingHeader("Hardware counters"))
     {
-        spawnEnemy();
+        return;
     }
-}
 
-void Game::sGUI()
-{
-    ImGui::Begin("Geometry Wars");
-    if (ImGui::BeginTabBar("Geometry Wars TabBar"))
+    if (ImGui::Checkbox("Sample per system", &m_perfEnabled))
     {
-        if (ImGui::BeginTabItem("Systems"))
+        m_perfSum = {};
+        m_perfShown = {};
+        m_perfFrames = 0;
+        if (m_perfEnabled && !m_perf.open())
         {
-            ImGui::Checkbox("User Input", &m_systems.input);
-            ImGui::Checkbox("Enemy Spawner", &m_systems.spawner);
-            ImGui::Checkbox("Movement", &m_systems.movement);
-            ImGui::Checkbox("Lifespan", &m_systems.lifespan);
-            ImGui::Checkbox("Collision", &m_systems.collision);
-            ImGui::Checkbox("Render", &m_systems.render);
-            
-            ImGui::EndTabItem();
+            m_perfEnabled = false;
         }
-        if (ImGui::BeginTabItem("Entity Manager"))
+        else if (!m_perfEnabled)
         {
-            auto drawEntityRow = [](std::shared_ptr<Entity> e)
-            {
-                ImGui::PushID(static_cast<int>(e->id()));
+            m_perf.close();
+        }
+    }
+    if (!m_perf.error().empty())
+    {
+        ImGui::TextWrapped("%s", m_perf.error().c_str());
+    }
+    if (!m_perfEnabled)
+    {
+        return;
+    }
 
-                // Color preview (fill color if available)
-                sf::Color preview = e->has<CShape>() ? e->get<CShape>().circle.getFillColor()
-                                                     : sf::Color(128, 128, 128);
-                ImVec4 imguiCol(preview.r / 255.f, preview.g / 255.f, preview.b / 255.f, preview.a / 255.f);
-                ImGui::ColorButton("##color", imguiCol, ImGuiColorEditFlags_NoTooltip, ImVec2(18, 18));
-                ImGui::SameLine();
-                
-                // Destroy toggle
-                if (ImGui::Button("D", ImVec2(20, 20)))
+    ImGui::Text("Per frame, averaged over %d frames", PERF_WINDOW);
+    if (m_workers)
+    {
+        ImGui::TextWrapped("Counters cover the main thread only; the %zu physics workers' share of collision is "
+                           "left out.", m_workers->size());
+    }
+    if (ImGui::BeginTable("PerfCounters", 2 + PerfCounters::Count, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+    {
+        ImGui::TableSetupColumn("System");
+        ImGui::TableSetupColumn("ms");
+        ImGui::TableSetupColumn("Cycles");
+        ImGui::TableSetupColumn("IPC");
+        ImGui::TableSetupColumn("L1D miss");
+        ImGui::TableSetupColumn("LLC miss");
+        ImGui::TableSetupColumn("Branch miss");
+        ImGui::TableHeadersRow();
+
+        const double frames = PERF_WINDOW;
+        for (size_t i = 0; i < m_perfShown.size(); i++)
+        {
+            const auto &row = m_perfShown[i];
+            const auto &c = row.counters.counts;
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(World::systemName(static_cast<World::System>(i)));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", static_cast<double>(row.ns) / frames * 1e-6);
+
+            for (int counter = 0; counter < PerfCounters::Count; counter++)
+            {
+                ImGui::TableNextColumn();
+                if (!m_perf.has(static_cast<PerfCounters::Counter>(counter)))
                 {
-                    e->destroy();
+                    ImGui::TextUnformatted("-");
                 }
-                ImGui::SameLine();
-
-                ImGui::Text("%zu  %s", e->id(), e->tag().c_str());
-                if (e->has<CTransform>())
+                else if (counter == PerfCounters::Instructions)
                 {
-                    auto &t = e->get<CTransform>();
-                    ImGui::SameLine();
-                    ImGui::Text("(%.0f,%.0f)", t.pos.x, t.pos.y);
+                    // shown as instructions per cycle
+                    ImGui::Text("%.2f", c[PerfCounters::Cycles] ? static_cast<double>(c[counter]) / static_cast<double>(c[PerfCounters::Cycles]) : 0.0);
                 }
-
-                ImGui::PopID();
-            };
-
-            if (ImGui::CollapsingHeader("Entities by Tag", ImGuiTreeNodeFlags_DefaultOpen))
-            {
-                const auto &entityMap = m_entities.getEntityMap();
-                for (const auto &[tag, vec] : entityMap)
+                else
                 {
-                    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_DefaultOpen;
-                    if (ImGui::TreeNodeEx(tag.c_str(), flags))
-                    {
-                        for (auto &e : vec)
-                        {
-                            drawEntityRow(e);
-                        }
-                        ImGui::TreePop();
-                    }
+                    ImGui::Text("%.0f", static_cast<double>(c[counter]) / frames);
                 }
             }
+        }
+        ImGui::EndTable();
+    }
+}
+
+void Game::guiFrameTimes()
+{
+    const auto &fs = m_frameStats;
+    ImGui::Text("Frames: %llu", static_cast<unsigned long long>(fs.frame.count()));
+    ImGui::Text("Over 16.6 ms: %llu   Over 8.3 ms: %llu (sim + render)",
+                static_cast<unsigned long long>(fs.over60), static_cast<unsigned long long>(fs.over120));
 
-            if (ImGui::CollapsingHeader("All Entities"))
+    if (ImGui::BeginTable("FrameTimes", 7, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+    {
+        ImGui::TableSetupColumn("Series");
+        ImGui::TableSetupColumn("Mean ms");
+        ImGui::TableSetupColumn("p50 ms");
+        ImGui::TableSetupColumn("p90 ms");
+        ImGui::TableSetupColumn("p99 ms");
+        ImGui::TableSetupColumn("p99.9 ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+
+        auto row = [](const char *name, const LatencyHistogram &h)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", h.mean() / 1000.0);
+            for (double p : {0.5, 0.9, 0.99, 0.999})
             {
-                for (auto &e : m_entities.getEntities())
-                {
-                    drawEntityRow(e);
-                }
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", static_cast<double>(h.percentile(p)) / 1000.0);
             }
-            
-            ImGui::EndTabItem();
-        }
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", static_cast<double>(h.max()) / 1000.0);
+        };
+        row("frame", fs.frame);
+        row("sim", fs.sim);
+        row("render", fs.render);
+        ImGui::EndTable();
+    }
 
-        ImGui::EndTabBar();
+    if (ImGui::Button("Dump (F10)")) dumpFrameStats();
+    ImGui::SameLine();
+    if (ImGui::Button("Reset")) m_frameStats.reset();
+}
+
+void Game::dumpFrameStats()
+{
+    if (!m_frameStats.writeCsv("frame_stats.csv") || !m_frameStats.writeJson("frame_stats.json"))
+    {
+        std::cerr << "Error: Could not write frame stats\n";
     }
-    
-    ImGui::End();
+}
+
+void Game::toggleTrace()
+{
+#ifdef ARCHANGEL_PROFILE
+    auto &trace = TraceRecorder::instance();
+    if (TraceRecorder::recording())
+    {
+        trace.stop();
+    }
+    else if (!trace.start("trace.json", 10.0))
+    {
+        std::cerr << "Error: Could not start trace recording\n";
+    }
+#endif
 }
 
 void Game::sRender()
@@ -534,34 +848,82 @@ void Game::sRender()
     
     m_window.clear();
 
-    for (auto &e : m_entities.getEntities())
+    // all particles go out in a single batched draw, underneath the entities
+    auto &particles = m_world.particles();
+    size_t particleVerts = particles.buildVertices();
+    if (particleVerts > 0)
     {
-        if (e->has<CShape>() && e->has<CTransform>())
-        {
-            auto &shape = e->get<CShape>();
-            auto &transform = e->get<CTransform>();
-            
-            shape.circle.setPosition(transform.pos);
-            shape.circle.setRotation(sf::degrees(transform.angle));
-           
-            m_window.draw(shape.circle);
-        }
+        m_window.draw(particles.vertices(), particleVerts, sf::PrimitiveType::Triangles);
+    }
+
+    m_shapes.build(m_world.entities().getEntities());
+    if (m_shapes.size() > 0)
+    {
+        m_window.draw(m_shapes.data(), m_shapes.size(), sf::PrimitiveType::Triangles);
+    }
+
+    // draw ui last; a frame that started the GUI must also finish it, even
+    // if F1 hid it in between
+    if (m_showGui || m_guiFrame)
+    {
+        PROFILE_SCOPE("render/imgui");
+        renderGui();
+    }
+}
+
+void Game::renderGui()
+{
+    if (m_config.gui.RATE <= 0.f)
+    {
+        if (m_guiFrame) ImGui::SFML::Render(m_window);
+        return;
+    }
+
+    if (m_guiTexture.getSize() != m_window.getSize() && !m_guiTexture.resize(m_window.getSize()))
+    {
+        std::cerr << "Error: Could not create GUI texture, drawing the GUI every frame\n";
+        m_config.gui.RATE = 0.f;
+        if (m_guiFrame) ImGui::SFML::Render(m_window);
+        return;
+    }
+
+    if (m_guiFrame)
+    {
+        m_guiTexture.clear(sf::Color::Transparent);
+        ImGui::SFML::Render(m_guiTexture);
+        m_guiTexture.display();
     }
 
-    // draw ui last
-    ImGui::SFML::Render(m_window);
+    if (!m_showGui) return;
 
-    m_window.display();
+    // the texture holds colour already multiplied by alpha
+    sf::Sprite overlay(m_guiTexture.getTexture());
+    m_window.draw(overlay, sf::BlendMode(sf::BlendMode::Factor::One, sf::BlendMode::Factor::OneMinusSrcAlpha));
 }
 
 void Game::sUserInput()
 {
-    while (auto event = m_window.pollEvent())
+    // movement keys are gathered into one input change per frame; the world
+    // applies it, and any shots, at the start of its next step
+    std::uint8_t input = m_inputBits;
+    auto setBit = [&input](sf::Keyboard::Scancode key, bool down)
     {
-        // pass the event to imgui to be parsed
-        ImGui::SFML::ProcessEvent(m_window, *event);
+        std::uint8_t bit = key == sf::Keyboard::Scancode::W   ? World::INPUT_UP
+                           : key == sf::Keyboard::Scancode::S ? World::INPUT_DOWN
+                           : key == sf::Keyboard::Scancode::A ? World::INPUT_LEFT
+                           : key == sf::Keyboard::Scancode::D ? World::INPUT_RIGHT
+                                                              : 0;
+        input = down ? (input | bit) : (input & ~bit);
+    };
 
-        auto &pInput = player()->get<CInput>();
+    while (auto event = m_window.pollEvent())
+    {
+        // pass the event to imgui to be parsed; a hidden GUI never polls its
+        // queue, so don't fill it
+        if (m_showGui)
+        {
+            ImGui::SFML::ProcessEvent(m_window, *event);
+        }
 
         if (event->is<sf::Event::Closed>())
         {
@@ -570,18 +932,23 @@ void Game::sUserInput()
 
         if (const auto *keyPressed = event->getIf<sf::Event::KeyPressed>())
         {
-            if (keyPressed->scancode == sf::Keyboard::Scancode::W) pInput.up = true;
-            if (keyPressed->scancode == sf::Keyboard::Scancode::S) pInput.down = true;
-            if (keyPressed->scancode == sf::Keyboard::Scancode::A) pInput.left = true;
-            if (keyPressed->scancode == sf::Keyboard::Scancode::D) pInput.right = true;
+            setBit(keyPressed->scancode, true);
+            if (keyPressed->scancode == sf::Keyboard::Scancode::P) setPaused(!m_paused);
+            if (keyPressed->scancode == sf::Keyboard::Scancode::F1) m_showGui = !m_showGui;
+            if (keyPressed->scancode == sf::Keyboard::Scancode::Q)
+            {
+                const int next = (static_cast<int>(m_special) + 1) % static_cast<int>(World::SpecialWeapon::Count);
+                m_special = static_cast<World::SpecialWeapon>(next);
+            }
+            if (keyPressed->scancode == sf::Keyboard::Scancode::F5) toggleReplayRecording();
+            if (keyPressed->scancode == sf::Keyboard::Scancode::F6) dumpWorld();
+            if (keyPressed->scancode == sf::Keyboard::Scancode::F9) toggleTrace();
+            if (keyPressed->scancode == sf::Keyboard::Scancode::F10) dumpFrameStats();
         }
 
         if (const auto *keyReleased = event->getIf<sf::Event::KeyReleased>())
         {
-            if (keyReleased->scancode == sf::Keyboard::Scancode::W) pInput.up = false;
-            if (keyReleased->scancode == sf::Keyboard::Scancode::S) pInput.down = false;
-            if (keyReleased->scancode == sf::Keyboard::Scancode::A) pInput.left = false;
-            if (keyReleased->scancode == sf::Keyboard::Scancode::D) pInput.right = false;
+            setBit(keyReleased->scancode, false);
         }
 
         if (const auto *mousePressed = event->getIf<sf::Event::MouseButtonPressed>())
@@ -590,53 +957,106 @@ void Game::sUserInput()
 
             if (mousePressed->button == sf::Mouse::Button::Left)
             {
-                spawnBullet(player(), mpos);
+                if (m_online) m_net.queueShot(mpos);
+                else m_world.queueShot(mpos);
             }
             else if (mousePressed->button == sf::Mouse::Button::Right)
             {
-                // TODO: call special weapon here
-                std::cout << "Right mouse (" << mpos.x << ", " << mpos.y << ")\n";
+                if (m_online) m_net.queueSpecial(mpos, m_special);
+                else m_world.queueSpecial(mpos, m_special);
             }
         }
     }
+
+    if (input != m_inputBits)
+    {
+        m_inputBits = input;
+        if (m_online) m_net.setInput(input);
+        else m_world.queueInput(input);
+    }
 }
 
-int Game::randInt(int min, int max)
+void Game::toggleReplayRecording()
 {
-    std::uniform_int_distribution<int> num(min, max);
-    return num(m_rng);
+    if (m_replay.isOpen())
+    {
+        if (!m_replay.close(m_world))
+        {
+            std::cerr << "Error: Could not finish replay.bin\n";
+        }
+        return;
+    }
+
+    // a replay is only meaningful if the world steps in fixed ticks
+    if (!m_config.deterministic.ENABLED)
+    {
+        std::cerr << "Error: Replays need 'Deterministic 1' in the config\n";
+        return;
+    }
+    m_replay.open("replay.bin", m_world, m_config.window.FPS, REPLAY_KEYFRAME_INTERVAL);
 }
 
-float Game::randFloat(float min, float max)
+void Game::dumpWorld()
 {
-    std::uniform_real_distribution<float> num(min, max);
-    return num(m_rng);
+    if (WorldFile::save("world.agw", m_world))
+    {
+        std::cout << "Saved world.agw at tick " << m_world.currentFrame() << "\n";
+    }
 }
 
-bool Game::isColliding(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b)
+void Game::setPaused(bool paused)
 {
-    auto &ta = a->get<CTransform>();
-    auto &tb = b->get<CTransform>();
+    // resuming after a rewind drops the ticks that were rewound over
+    if (m_paused && !paused && m_rewindBack > 0)
+    {
+        m_rewind.discard(static_cast<size_t>(m_rewindBack));
+        m_rewindBack = 0;
+        m_rewindCountdown = std::max(m_config.rewind.EVERY, 1) - 1;
+    }
+    m_paused = paused;
+}
 
-    auto &ca = a->get<CCollision>();
-    auto &cb = b->get<CCollision>();
+void Game::setRewindEnabled(bool enabled)
+{
+    // a client's world is rebuilt from the server's snapshots every frame
+    m_rewindEnabled = enabled && !m_online;
+    m_rewindBack = 0;
+    m_rewindCountdown = 0;
+    if (!m_rewindEnabled)
+    {
+        m_rewind.reset(0, 0, 0);
+        return;
+    }
 
-    float dx = ta.pos.x - tb.pos.x;
-    float dy = ta.pos.y - tb.pos.y;
+    const size_t budget = static_cast<size_t>(std::max(m_config.rewind.MB, 1)) * 1024 * 1024;
+    m_rewind.reset(REWIND_SNAPSHOTS, REWIND_RESERVE_ENTITIES, REWIND_RESERVE_PARTICLES, budget);
+    captureRewind();
+}
 
-    float dist2 = dx * dx + dy * dy;
-    float radiusSum = ca.radius + cb.radius;
+void Game::captureRewind()
+{
+    if (!m_rewindEnabled || m_rewindCountdown-- > 0) return;
+    m_rewindCountdown = std::max(m_config.rewind.EVERY, 1) - 1;
 
-    return dist2 <= radiusSum * radiusSum;
+    PROFILE_SCOPE("rewind/capture");
+    auto start = std::chrono::steady_clock::now();
+    m_rewind.capture(m_world);
+    m_captureUs = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
 }
 
-void Game::respawnPlayer(std::shared_ptr<Entity> player)
+void Game::rewind(int back)
 {
-    auto size = m_window.getSize();
-    float spawnX = size.x * 0.5;
-    float spawnY = size.y * 0.5;
+    // the recording can't follow the world backwards
+    if (m_replay.isOpen())
+    {
+        toggleReplayRecording();
+    }
 
-    auto &transform = player->get<CTransform>();
-    transform.pos = Vec2<float>(spawnX, spawnY);
-    transform.velocity = Vec2<float>(0.f, 0.f);
+    auto start = std::chrono::steady_clock::now();
+    if (m_rewind.restore(m_world, static_cast<size_t>(back)))
+    {
+        m_rewindBack = back;
+    }
+    m_restoreUs = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+    m_inspector.dirty = true;
 }
@@ -1,82 +1,154 @@
 #pragma once
 
-#include "Entity.hpp"
-#include "EntityManager.hpp"
+#include "Config.h"
+#include "FrameStats.hpp"
+#include "NetClient.h"
+#include "PerfCounters.h"
+#include "Replay.h"
+#include "Profiler.hpp"
+#include "ShapeBatch.hpp"
+#include "World.h"
+#include "WorldFile.h"
+#include "WorldSnapshot.hpp"
 
 #include "imgui-SFML.h"
 #include "imgui.h"
 #include "imgui_stdlib.h"
 
 #include <SFML/Graphics.hpp>
-#include <random>
-
-struct PlayerConfig
-{
-    int SR, CR, FR, FG, FB, OR, OG, OB, OT, V;
-    float S;
-};
-struct EnemyConfig
-{
-    int SR, CR, OR, OG, OB, OT, VMIN, VMAX, L, SI;
-    float SMIN, SMAX;
-};
-struct BulletConfig
-{
-    int SR, CR, FR, FG, FB, OR, OG, OB, OT, V, L;
-    float S;
-};
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 
 class Game
 {
     sf::RenderWindow m_window;
-    EntityManager m_entities;
-    std::mt19937 m_rng{std::random_device{}()};
+    World m_world;
+    GameConfig m_config;
+    ShapeBatch m_shapes;
+    FrameStats m_frameStats;
+    PerfCounters m_perf;
+    std::vector<float> m_profileScratch;
     sf::Font m_font;
     sf::Text m_text;
-    PlayerConfig m_playerConfig{};
-    EnemyConfig m_enemyConfig{};
-    BulletConfig m_bulletConfig{};
     sf::Clock m_deltaClock;
-    int m_score = 0;
-    int m_currentFrame = 0;
-    int m_lastEnemySpawnTime = 0;
+
+    // The debug GUI runs at m_config.gui.RATE; in between, the last ImGui
+    // frame is drawn again from m_guiTexture. F1 hides it entirely.
+    sf::RenderTexture m_guiTexture;
+    sf::Clock m_guiClock;
+    bool m_showGui = true;
+    bool m_guiFrame = false;
+
+    // deterministic mode steps the world in fixed ticks of 1 / FPS
+    static constexpr int MAX_TICKS_PER_FRAME = 4;
+    float m_tickAccumulator = 0.f;
+
+    // F5 records the session to replay.bin (deterministic mode only)
+    static constexpr int REPLAY_KEYFRAME_INTERVAL = 600;
+    ReplayWriter m_replay;
+    std::uint8_t m_inputBits = 0;
+
+    // fired on right-click; Q switches to the next one
+    World::SpecialWeapon m_special = World::SpecialWeapon::Laser;
+
+    // With rewind on (m_config.rewind, or the Systems tab), a snapshot every
+    // EVERY steps, up to REWIND_SNAPSHOTS of them within the MB budget; while
+    // paused, the Systems tab scrubs back through them and resuming carries
+    // on from the restored one. Never captured while online.
+    static constexpr size_t REWIND_SNAPSHOTS = 600;
+    static constexpr size_t REWIND_RESERVE_ENTITIES = 1024;
+    static constexpr size_t REWIND_RESERVE_PARTICLES = 4096;
+    WorldSnapshotRing m_rewind;
+    bool m_rewindEnabled = false;
+    int m_rewindCountdown = 0;
+    int m_rewindBack = 0;
+    float m_captureUs = 0.f;
+    float m_restoreUs = 0.f;
+
+    // with a Net host in the config the game is a client of that server: the
+    // world is never stepped here, only rebuilt from its snapshots
+    NetClient m_net;
+    bool m_online = false;
+
+    // lent to the world for the systems that split across threads
+    std::unique_ptr<ThreadPool> m_workers;
     bool m_paused = false;
     bool m_configLoaded = false;
     bool m_imguiInitialized = false;
-    
+
     struct SystemToggles
     {
         bool input = true;
-        bool spawner = true;
-        bool movement = true;
-        bool lifespan = true;
-        bool collision = true;
         bool render = true;
     } m_systems;
 
+    // per-system hardware counters, summed over PERF_WINDOW frames and then
+    // published for the profiler tab
+    static constexpr int PERF_WINDOW = 60;
+    struct SystemPerf
+    {
+        PerfSample counters;
+        std::uint64_t ns = 0;
+    };
+    using SystemPerfTable = std::array<SystemPerf, static_cast<size_t>(World::System::Count)>;
+    SystemPerfTable m_perfSum{};
+    SystemPerfTable m_perfShown{};
+    int m_perfFrames = 0;
+    bool m_perfEnabled = false;
+
+    // Entity Manager tab. rows is a filtered, sorted snapshot that is rebuilt
+    // when the filter or sort changes and otherwise a few times a second, so
+    // a frame only pays for the rows the clipper shows.
+    //
+    // Entity slots are recycled, so each row keeps the id it was built with
+    // and treats a mismatch as a dead entity.
+    struct EntityRow
+    {
+        Entity *entity = nullptr;
+        size_t id = 0;
+
+        Entity *get() const
+        {
+            return entity && entity->id() == id ? entity : nullptr;
+        }
+    };
+
+    struct EntityInspector
+    {
+        std::vector<EntityRow> rows;
+        ImGuiTextFilter idFilter;
+        std::string tag;
+        EntityRow selected;
+        ImGuiID sortColumn = 0;
+        bool sortAscending = true;
+        bool autoRefresh = true;
+        bool dirty = true;
+        double lastBuild = 0.0;
+    } m_inspector;
+
     void init(const std::string &config);
     void setPaused(bool paused);
 
-    int randInt(int min, int max);
-    float randFloat(float min, float max);
-
-    void sMovement(float dt);
     void sUserInput();
-    void sLifespan();
     void sRender();
+    void renderGui();
     void sGUI();
-    void sEnemySpawner();
-    void sCollision();
-
-    void spawnPlayer();
-    void spawnEnemy();
-    void spawnSmallEnemies(std::shared_ptr<Entity> entity);
-    void spawnBullet(std::shared_ptr<Entity> entity, const Vec2<float> &mousePos);
-    void spawnSpecialWeapon(std::shared_ptr<Entity> entity);
-    bool isColliding(std::shared_ptr<Entity> a, std::shared_ptr<Entity> b);
-    void respawnPlayer(std::shared_ptr<Entity> player);
-
-    std::shared_ptr<Entity> player();
+    void guiProfiler();
+    void guiFrameTimes();
+    void guiPerfCounters();
+    void guiEntities();
+    void guiEntityDetails(Entity &e);
+    void buildEntityRows();
+    void dumpFrameStats();
+    void toggleTrace();
+    void toggleReplayRecording();
+    void dumpWorld();
+    void setRewindEnabled(bool enabled);
+    void captureRewind();
+    void rewind(int back);
 
   public:
     Game(const std::string &config);
@@ -0,0 +1,141 @@
+#include "Config.h"
+#include "FrameStats.hpp"
+#include "Profiler.hpp"
+#include "World.h"
+#include "WorldFile.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Steps the simulation with no window as fast as the machine allows.
+// usage: headless [config] [--ticks n] [--trace trace.json] [--hashes hashes.txt]
+//                 [--load load.agw] [--save save.agw]
+// --trace records the whole run as a Chrome trace (profiling builds).
+// --hashes writes "tick hash" for every tick; diff two of them to find the
+// first tick where runs diverge. --load starts the run from a world dump
+// (see WorldFile.h) and --save dumps the world at the end.
+int main(int argc, char *argv[])
+{
+    std::string configPath = "res/config.txt";
+    long ticks = 10000;
+    std::string tracePath;
+    std::string hashPath;
+    std::string loadPath;
+    std::string savePath;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--ticks" && hasValue) ticks = std::atol(argv[++i]);
+        else if (arg == "--trace" && hasValue) tracePath = argv[++i];
+        else if (arg == "--hashes" && hasValue) hashPath = argv[++i];
+        else if (arg == "--load" && hasValue) loadPath = argv[++i];
+        else if (arg == "--save" && hasValue) savePath = argv[++i];
+        else if (arg.rfind("--", 0) != 0) configPath = arg;
+        else
+        {
+            std::cerr << "usage: headless [config] [--ticks n] [--trace trace.json] [--hashes hashes.txt] "
+                         "[--load load.agw] [--save save.agw]\n";
+            return 2;
+        }
+    }
+
+    GameConfig config;
+    if (!loadConfig(configPath, config))
+    {
+        return 1;
+    }
+
+    World world;
+    world.init(config);
+    if (!loadPath.empty())
+    {
+        auto loadStart = std::chrono::steady_clock::now();
+        if (!WorldFile::load(loadPath, world))
+        {
+            return 1;
+        }
+        std::chrono::duration<double, std::milli> loadMs = std::chrono::steady_clock::now() - loadStart;
+        std::cout << "loaded " << world.entities().getEntities().size() << " entities from " << loadPath << " in "
+                  << loadMs.count() << " ms\n";
+    }
+    const float dt = 1.f / static_cast<float>(config.window.FPS);
+
+    std::ofstream hashes;
+    if (!hashPath.empty())
+    {
+        hashes.open(hashPath);
+        if (!hashes.is_open())
+        {
+            std::cerr << "Error: Could not open hash file " << hashPath << "\n";
+            return 1;
+        }
+    }
+
+#ifdef ARCHANGEL_PROFILE
+    if (!tracePath.empty() && !TraceRecorder::instance().start(tracePath, 1e9))
+    {
+        std::cerr << "Error: Could not open trace file " << tracePath << "\n";
+        return 1;
+    }
+#endif
+
+    LatencyHistogram tickTimes;
+    auto start = std::chrono::steady_clock::now();
+    for (long i = 0; i < ticks; i++)
+    {
+        auto tickStart = std::chrono::steady_clock::now();
+        PROFILE_FRAME_BEGIN();
+        world.step(dt, []([[maybe_unused]] World::System system, auto &&fn)
+        {
+            PROFILE_SCOPE_NAMED(World::systemName(system));
+            fn();
+        });
+        PROFILE_FRAME_END();
+        tickTimes.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - tickStart).count()));
+
+        if (hashes.is_open())
+        {
+            char line[40];
+            std::snprintf(line, sizeof(line), "%ld %016llx\n", i, static_cast<unsigned long long>(world.hash()));
+            hashes << line;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+#ifdef ARCHANGEL_PROFILE
+    if (TraceRecorder::recording())
+    {
+        TraceRecorder::instance().stop();
+    }
+#endif
+
+    std::cout << ticks << " ticks in " << elapsed.count() << " s ("
+              << ticks / elapsed.count() << " ticks/s), "
+              << world.entities().getEntities().size() << " entities, score "
+              << world.player()->get<CScore>().score << "\n";
+    char hash[20];
+    std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(world.hash()));
+    std::cout << "seed " << world.seed() << ", final hash " << hash << "\n";
+    std::cout << "tick us: p50 " << tickTimes.percentile(0.5) << ", p90 " << tickTimes.percentile(0.9)
+              << ", p99 " << tickTimes.percentile(0.99) << ", p99.9 " << tickTimes.percentile(0.999)
+              << ", max " << tickTimes.max() << "\n";
+
+    if (!savePath.empty())
+    {
+        auto saveStart = std::chrono::steady_clock::now();
+        if (!WorldFile::save(savePath, world))
+        {
+            return 1;
+        }
+        std::chrono::duration<double, std::milli> saveMs = std::chrono::steady_clock::now() - saveStart;
+        std::cout << "saved " << savePath << " in " << saveMs.count() << " ms\n";
+    }
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include "Lz.h"
+
+#include <array>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t MAX_OFFSET = 65535;
+// matches stop this far from the end so the tail is always literals
+constexpr size_t END_LITERALS = 5;
+constexpr size_t MATCH_LIMIT = 12;
+constexpr int HASH_BITS = 14;
+
+std::uint32_t read32(const std::uint8_t *p)
+{
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+std::uint32_t hash(std::uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void putLength(std::vector<std::uint8_t> &out, size_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        out.push_back(255);
+    }
+    out.push_back(static_cast<std::uint8_t>(length));
+}
+
+void putSequence(std::vector<std::uint8_t> &out, const std::uint8_t *literals, size_t literalLength, size_t offset,
+                 size_t matchLength)
+{
+    const size_t m = matchLength ? matchLength - MIN_MATCH : 0;
+    out.push_back(static_cast<std::uint8_t>((literalLength < 15 ? literalLength : 15) << 4 | (m < 15 ? m : 15)));
+    if (literalLength >= 15) putLength(out, literalLength - 15);
+    out.insert(out.end(), literals, literals + literalLength);
+    if (!matchLength) return;
+
+    out.push_back(static_cast<std::uint8_t>(offset));
+    out.push_back(static_cast<std::uint8_t>(offset >> 8));
+    if (m >= 15) putLength(out, m - 15);
+}
+
+// reads a length extension onto length
+bool getLength(const std::uint8_t *&ip, const std::uint8_t *end, size_t &length)
+{
+    std::uint8_t b;
+    do
+    {
+        if (ip == end) return false;
+        b = *ip++;
+        length += b;
+    } while (b == 255);
+    return true;
+}
+}
+
+void lzCompress(const std::uint8_t *data, size_t size, std::vector<std::uint8_t> &out)
+{
+    out.reserve(out.size() + size + size / 255 + 16);
+
+    // positions + 1, so zero means empty
+    auto table = std::make_unique<std::array<std::uint32_t, 1 << HASH_BITS>>();
+    table->fill(0);
+
+    size_t anchor = 0;
+    size_t ip = 0;
+    size_t misses = 0;
+    while (size >= MATCH_LIMIT && ip <= size - MATCH_LIMIT)
+    {
+        const std::uint32_t v = read32(data + ip);
+        std::uint32_t &slot = (*table)[hash(v)];
+        const size_t ref = slot;
+        slot = static_cast<std::uint32_t>(ip + 1);
+
+        if (ref == 0 || ip + 1 - ref > MAX_OFFSET || read32(data + ref - 1) != v)
+        {
+            // skip faster through data that doesn't compress
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+
+        const size_t match = ref - 1;
+        size_t length = MIN_MATCH;
+        while (ip + length < size - END_LITERALS && data[match + length] == data[ip + length])
+        {
+            length++;
+        }
+
+        putSequence(out, data + anchor, ip - anchor, ip - match, length);
+        ip += length;
+        anchor = ip;
+        misses = 0;
+    }
+    putSequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+bool lzDecompress(const std::uint8_t *data, size_t size, std::uint8_t *out, size_t rawSize)
+{
+    const std::uint8_t *ip = data;
+    const std::uint8_t *const end = data + size;
+    std::uint8_t *op = out;
+    std::uint8_t *const outEnd = out + rawSize;
+
+    while (ip < end)
+    {
+        const std::uint8_t token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(ip, end, literals)) return false;
+        if (literals > static_cast<size_t>(end - ip) || literals > static_cast<size_t>(outEnd - op)) return false;
+        std::memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        if (ip == end) break;
+
+        if (end - ip < 2) return false;
+        const size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - out)) return false;
+
+        size_t length = token & 15;
+        if (length == 15 && !getLength(ip, end, length)) return false;
+        length += MIN_MATCH;
+        if (length > static_cast<size_t>(outEnd - op)) return false;
+
+        const std::uint8_t *match = op - offset;
+        if (offset >= length)
+        {
+            std::memcpy(op, match, length);
+            op += length;
+        }
+        else
+        {
+            // overlapping copy repeats the last offset bytes
+            for (size_t i = 0; i < length; i++)
+            {
+                *op++ = match[i];
+            }
+        }
+    }
+    return op == outEnd;
+}
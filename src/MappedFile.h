@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only memory mapping of a whole file (POSIX mmap). Pages load on
+// first touch, so opening a large replay or save costs nothing up front.
+class MappedFile
+{
+    const std::uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+
+  public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Maps path, replacing any previous mapping. Prints the reason and
+    // returns false if the file can't be opened or mapped.
+    bool open(const std::string &path);
+    void close();
+
+    const std::uint8_t *data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+};
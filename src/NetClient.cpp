@@ -0,0 +1,208 @@
+#include "NetClient.h"
+#include "Bytes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+bool NetClient::connect(const std::string &host, std::uint16_t port)
+{
+    if (!NetAddress::parse(host, port, m_server))
+    {
+        std::cerr << "Error: Could not resolve server " << host << "\n";
+        return false;
+    }
+    m_receive.resize(UdpSocket::MAX_DATAGRAM);
+    m_challenged = false;
+    m_valid.fill(false);
+    m_latest = NET_NO_TICK;
+    m_partTick = NET_NO_TICK;
+    m_renderTick = -1.0;
+    return m_socket.open(0);
+}
+
+const NetSnapshot *NetClient::find(std::uint32_t tick) const
+{
+    const size_t slot = tick % HISTORY;
+    return tick != NET_NO_TICK && m_valid[slot] && m_snapshots[slot].tick == tick ? &m_snapshots[slot] : nullptr;
+}
+
+void NetClient::sendInput()
+{
+    if (!m_socket.isOpen()) return;
+
+    m_packet.clear();
+    ByteWriter out(m_packet);
+    if (!m_challenged)
+    {
+        out.put(NET_CONNECT);
+        out.put(NET_PROTOCOL);
+        m_packet.resize(NET_CONNECT_SIZE);
+        m_socket.send(m_server, m_packet.data(), m_packet.size());
+        return;
+    }
+
+    const size_t shots = std::min(m_shots.size(), NET_MAX_SHOTS);
+    out.put(NET_INPUT);
+    out.put(NET_PROTOCOL);
+    out.put(m_token);
+    out.put(m_latest);
+    out.put(m_input);
+    out.put(m_firstShot);
+    out.put(static_cast<std::uint8_t>(shots));
+    for (size_t i = 0; i < shots; i++)
+    {
+        out.put(m_shots[i].kind);
+        out.put(m_shots[i].input);
+        out.put(m_shots[i].target.x);
+        out.put(m_shots[i].target.y);
+    }
+    m_socket.send(m_server, m_packet.data(), m_packet.size());
+}
+
+void NetClient::receive()
+{
+    NetAddress from;
+    size_t size = 0;
+    while (m_socket.receive(from, m_receive.data(), m_receive.size(), size))
+    {
+        if (!(from == m_server)) continue;
+
+        m_bytesReceived += size;
+        ByteReader in(m_receive.data(), size);
+        std::uint8_t type = 0;
+        if (!in.get(type)) continue;
+        if (type == NET_SNAPSHOT)
+        {
+            onFragment(in);
+        }
+        else if (type == NET_CHALLENGE && in.get(m_token))
+        {
+            m_challenged = true;
+        }
+    }
+}
+
+void NetClient::onFragment(ByteReader &in)
+{
+    std::uint32_t tick = 0;
+    std::uint32_t baseline = 0;
+    std::uint32_t shotsApplied = 0;
+    std::uint16_t index = 0;
+    std::uint16_t count = 0;
+    if (!in.get(tick) || !in.get(baseline) || !in.get(shotsApplied) || !in.get(index) || !in.get(count)) return;
+    if (count == 0 || index >= count || in.remaining() > NET_FRAGMENT_PAYLOAD) return;
+
+    // drop the shots the server has applied
+    if (shotsApplied > m_firstShot)
+    {
+        const size_t done = std::min<size_t>(shotsApplied - m_firstShot, m_shots.size());
+        m_shots.erase(m_shots.begin(), m_shots.begin() + static_cast<std::ptrdiff_t>(done));
+        m_firstShot = shotsApplied;
+    }
+
+    if (m_latest != NET_NO_TICK && tick <= m_latest) return;
+    if (tick != m_partTick)
+    {
+        if (m_partTick != NET_NO_TICK && tick < m_partTick) return;
+        if (m_partTick != NET_NO_TICK && m_partReceived < m_partCount) m_snapshotsDropped++;
+
+        m_partTick = tick;
+        m_partBaseline = baseline;
+        m_partCount = count;
+        m_partReceived = 0;
+        m_partSize = 0;
+        m_partSeen.assign(count, 0);
+        m_partData.resize(static_cast<size_t>(count) * NET_FRAGMENT_PAYLOAD);
+    }
+    if (count != m_partCount || m_partSeen[index]) return;
+
+    const size_t length = in.remaining();
+    const std::uint8_t *payload = in.skip(length);
+    std::copy(payload, payload + length, m_partData.begin() + static_cast<std::ptrdiff_t>(index * NET_FRAGMENT_PAYLOAD));
+    if (index == count - 1)
+    {
+        m_partSize = index * NET_FRAGMENT_PAYLOAD + length;
+    }
+    m_partSeen[index] = 1;
+
+    if (++m_partReceived == m_partCount)
+    {
+        decode();
+    }
+}
+
+void NetClient::decode()
+{
+    const NetSnapshot *base = find(m_partBaseline);
+    if (m_partBaseline != NET_NO_TICK && !base)
+    {
+        m_snapshotsDropped++;
+        return;
+    }
+
+    // decoded aside: the baseline may sit in the slot this tick lands in
+    m_decoded.tick = m_partTick;
+    if (!decodeSnapshot(m_partData.data(), m_partSize, base, m_decoded))
+    {
+        m_snapshotsDropped++;
+        return;
+    }
+
+    if (m_latest != NET_NO_TICK)
+    {
+        m_gap = m_partTick - m_latest;
+    }
+    m_latest = m_partTick;
+    const size_t slot = m_latest % HISTORY;
+    std::swap(m_snapshots[slot], m_decoded);
+    m_valid[slot] = true;
+    m_snapshotsReceived++;
+}
+
+bool NetClient::interpolate(float ticks, World &world)
+{
+    if (m_latest == NET_NO_TICK) return false;
+
+    // two snapshot gaps behind the newest leaves room for one to be lost;
+    // drift toward that rather than jumping unless far off
+    const double target = static_cast<double>(m_latest) - 2.0 * m_gap;
+    const double next = m_renderTick + ticks;
+    if (m_renderTick < 0.0 || std::abs(next - target) > 4.0 * m_gap)
+    {
+        m_renderTick = target;
+    }
+    else
+    {
+        m_renderTick = next + (target - next) * 0.05;
+    }
+
+    const NetSnapshot *from = nullptr;
+    const NetSnapshot *to = nullptr;
+    for (size_t i = 0; i < HISTORY; i++)
+    {
+        if (!m_valid[i]) continue;
+        const NetSnapshot &s = m_snapshots[i];
+        const auto tick = static_cast<double>(s.tick);
+        if (tick <= m_renderTick)
+        {
+            if (!from || s.tick > from->tick) from = &s;
+        }
+        else if (!to || s.tick < to->tick)
+        {
+            to = &s;
+        }
+    }
+
+    if (from && to)
+    {
+        const auto t = static_cast<float>((m_renderTick - from->tick) / static_cast<double>(to->tick - from->tick));
+        NetSnapshot::lerp(*from, *to, t, m_blend);
+        m_blend.apply(world);
+    }
+    else
+    {
+        (from ? from : to)->apply(world);
+    }
+    return true;
+}
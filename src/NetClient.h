@@ -0,0 +1,122 @@
+#pragma once
+
+#include "NetProtocol.h"
+#include "NetSnapshot.h"
+#include "NetSocket.h"
+#include "Vec2.hpp"
+#include "World.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The remote end of NetServer: sends input, reassembles and decodes
+// snapshots, and shows the world a little behind the newest one,
+// interpolating between the two snapshots around the render time so a late
+// or lost packet doesn't stall the picture.
+class NetClient
+{
+    static constexpr size_t HISTORY = 32;
+
+    UdpSocket m_socket;
+    NetAddress m_server;
+    // from the server's challenge; until then input goes out as connects
+    std::uint64_t m_token = 0;
+    bool m_challenged = false;
+
+    // decoded snapshots by tick % HISTORY, doubling as baselines
+    std::array<NetSnapshot, HISTORY> m_snapshots;
+    std::array<bool, HISTORY> m_valid{};
+    NetSnapshot m_decoded;
+    NetSnapshot m_blend;
+    std::uint32_t m_latest = NET_NO_TICK;
+    std::uint32_t m_gap = 1;
+    double m_renderTick = -1.0;
+
+    // the snapshot being reassembled
+    std::uint32_t m_partTick = NET_NO_TICK;
+    std::uint32_t m_partBaseline = NET_NO_TICK;
+    std::uint16_t m_partCount = 0;
+    std::uint16_t m_partReceived = 0;
+    size_t m_partSize = 0;
+    std::vector<std::uint8_t> m_partData;
+    std::vector<std::uint8_t> m_partSeen;
+
+    std::uint8_t m_input = 0;
+    // shots and specials, as the World actions they become on the server
+    std::vector<World::PlayerAction> m_shots;
+    std::uint32_t m_firstShot = 0;
+
+    std::vector<std::uint8_t> m_receive;
+    std::vector<std::uint8_t> m_packet;
+    std::uint64_t m_bytesReceived = 0;
+    std::uint64_t m_snapshotsReceived = 0;
+    std::uint64_t m_snapshotsDropped = 0;
+
+    const NetSnapshot *find(std::uint32_t tick) const;
+    void onFragment(ByteReader &in);
+    void decode();
+
+  public:
+    bool connect(const std::string &host, std::uint16_t port);
+
+    bool isOpen() const
+    {
+        return m_socket.isOpen();
+    }
+
+    // World::INPUT_* bits, sent with every input packet.
+    void setInput(std::uint8_t input)
+    {
+        m_input = input;
+    }
+
+    // Resent with every input packet until the server has applied it.
+    void queueShot(const Vec2<float> &target)
+    {
+        m_shots.push_back({World::PlayerAction::Kind::Shot, 0, target});
+    }
+
+    void queueSpecial(const Vec2<float> &target, World::SpecialWeapon weapon)
+    {
+        m_shots.push_back({World::PlayerAction::Kind::Special, static_cast<std::uint8_t>(weapon), target});
+    }
+
+    void sendInput();
+
+    // Reads every waiting packet.
+    void receive();
+
+    // Advances the render time by ticks and writes the interpolated world
+    // into world. Returns false until the first snapshot arrives.
+    bool interpolate(float ticks, World &world);
+
+    // The newest complete snapshot, or nullptr.
+    const NetSnapshot *latest() const
+    {
+        return find(m_latest);
+    }
+
+    std::uint64_t bytesReceived() const
+    {
+        return m_bytesReceived;
+    }
+
+    std::uint64_t snapshotsReceived() const
+    {
+        return m_snapshotsReceived;
+    }
+
+    // snapshots given up on: missing fragments or an expired baseline
+    std::uint64_t snapshotsDropped() const
+    {
+        return m_snapshotsDropped;
+    }
+
+    // how far behind the newest snapshot the world is shown, in ticks
+    double renderDelay() const
+    {
+        return m_renderTick < 0.0 ? 0.0 : static_cast<double>(m_latest) - m_renderTick;
+    }
+};
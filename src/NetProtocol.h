@@ -0,0 +1,46 @@
+#pragma once
+
+// Client/server packets. Everything goes over UDP and nothing is
+// acknowledged on its own: a client's input packet carries the tick of the
+// last snapshot it has, which the server then encodes against, and shots
+// ride along in every input packet until a snapshot reports them applied.
+//
+//   Connect   client -> server, every client frame until a challenge comes
+//             u8 NET_CONNECT, u32 NET_PROTOCOL, zeros up to NET_CONNECT_SIZE
+//   Challenge server -> client, in reply to a connect or to input with the
+//             wrong token
+//             u8 NET_CHALLENGE, u64 token
+//   Input     client -> server, every client frame
+//             u8 NET_INPUT, u32 NET_PROTOCOL, u64 token, u32 last
+//             complete snapshot tick (NET_NO_TICK before the first),
+//             u8 World::INPUT_* bits,
+//             u32 sequence number of the first shot, u8 shot count,
+//             u8 World::PlayerAction::Kind, u8 bits, f32 x, f32 y per
+//             shot; a special weapon goes as a shot of kind Special with
+//             its World::SpecialWeapon as the bits
+//   Snapshot  server -> client, one fragment of an encoded snapshot
+//             u8 NET_SNAPSHOT, u32 tick, u32 baseline tick (NET_NO_TICK for
+//             none), u32 shots applied so far, u16 fragment index,
+//             u16 fragment count, up to NET_FRAGMENT_PAYLOAD bytes
+//
+// A snapshot missing any fragment is dropped; the client keeps acking the
+// last one it has and the next delta is simply larger.
+//
+// The token is a keyed hash of the client's address, so only input from an
+// address that got the challenge makes the server start sending snapshots
+// there, and a challenge is smaller than what asked for it: a spoofed
+// source can't turn the server on someone else.
+
+#include <cstddef>
+#include <cstdint>
+
+constexpr std::uint8_t NET_INPUT = 1;
+constexpr std::uint8_t NET_SNAPSHOT = 2;
+constexpr std::uint8_t NET_CONNECT = 3;
+constexpr std::uint8_t NET_CHALLENGE = 4;
+constexpr std::uint32_t NET_PROTOCOL = 0x34505741; // "AWP4"
+constexpr size_t NET_CONNECT_SIZE = 64;
+constexpr std::uint32_t NET_NO_TICK = 0xFFFFFFFF;
+// keeps a fragment under a typical 1500-byte MTU
+constexpr size_t NET_FRAGMENT_PAYLOAD = 1200;
+constexpr size_t NET_MAX_SHOTS = 16;
@@ -0,0 +1,247 @@
+#include "NetServer.h"
+#include "Bytes.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <iostream>
+#include <random>
+
+namespace
+{
+// SipHash-2-4 of a single 8-byte word
+std::uint64_t sipHash(const std::uint64_t key[2], std::uint64_t word)
+{
+    std::uint64_t v0 = key[0] ^ 0x736f6d6570736575ull;
+    std::uint64_t v1 = key[1] ^ 0x646f72616e646f6dull;
+    std::uint64_t v2 = key[0] ^ 0x6c7967656e657261ull;
+    std::uint64_t v3 = key[1] ^ 0x7465646279746573ull;
+    auto round = [&]
+    {
+        v0 += v1;
+        v1 = std::rotl(v1, 13) ^ v0;
+        v0 = std::rotl(v0, 32);
+        v2 += v3;
+        v3 = std::rotl(v3, 16) ^ v2;
+        v0 += v3;
+        v3 = std::rotl(v3, 21) ^ v0;
+        v2 += v1;
+        v1 = std::rotl(v1, 17) ^ v2;
+        v2 = std::rotl(v2, 32);
+    };
+    auto block = [&](std::uint64_t m)
+    {
+        v3 ^= m;
+        round();
+        round();
+        v0 ^= m;
+    };
+    block(word);
+    block(8ull << 56); // the length, with no tail bytes
+    v2 ^= 0xff;
+    for (int i = 0; i < 4; i++) round();
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+} // namespace
+
+bool NetServer::open(std::uint16_t port)
+{
+    std::random_device random;
+    for (auto &half : m_secret)
+    {
+        half = (static_cast<std::uint64_t>(random()) << 32) ^ random();
+    }
+    m_receive.resize(UdpSocket::MAX_DATAGRAM);
+    return m_socket.open(port);
+}
+
+std::uint64_t NetServer::token(const NetAddress &address) const
+{
+    return sipHash(m_secret, static_cast<std::uint64_t>(address.host) << 16 | address.port);
+}
+
+void NetServer::challenge(const NetAddress &address)
+{
+    m_packet.clear();
+    ByteWriter out(m_packet);
+    out.put(NET_CHALLENGE);
+    out.put(token(address));
+    m_socket.send(address, m_packet.data(), m_packet.size());
+}
+
+const NetSnapshot *NetServer::snapshot(std::uint32_t tick) const
+{
+    const size_t slot = tick % HISTORY;
+    return tick != NET_NO_TICK && m_captured[slot] && m_history[slot].tick == tick ? &m_history[slot] : nullptr;
+}
+
+void NetServer::receive(World &world, double now)
+{
+    NetAddress from;
+    size_t size = 0;
+    while (m_socket.receive(from, m_receive.data(), m_receive.size(), size))
+    {
+        ByteReader in(m_receive.data(), size);
+        std::uint8_t type = 0;
+        std::uint32_t protocol = 0;
+        if (!in.get(type) || !in.get(protocol) || protocol != NET_PROTOCOL) continue;
+
+        // padded so the challenge is never the bigger packet
+        if (type == NET_CONNECT)
+        {
+            if (size >= NET_CONNECT_SIZE) challenge(from);
+            continue;
+        }
+
+        std::uint64_t clientToken = 0;
+        std::uint32_t ack = 0;
+        std::uint8_t input = 0;
+        std::uint32_t firstShot = 0;
+        std::uint8_t shots = 0;
+        if (type != NET_INPUT || !in.get(clientToken) || !in.get(ack) || !in.get(input) || !in.get(firstShot) ||
+            !in.get(shots))
+        {
+            continue;
+        }
+        // a stale token, say from before a server restart
+        if (clientToken != token(from))
+        {
+            challenge(from);
+            continue;
+        }
+
+        auto it = std::find_if(m_clients.begin(), m_clients.end(), [&](const Client &c) { return c.address == from; });
+        if (it == m_clients.end())
+        {
+            if (m_clients.size() >= m_maxClients) continue;
+            std::cout << "Client " << from.toString() << " connected\n";
+            m_clients.push_back({});
+            it = m_clients.end() - 1;
+            it->address = from;
+        }
+        Client &client = *it;
+        const bool controls = it == m_clients.begin();
+
+        client.lastHeard = now;
+        if (ack != NET_NO_TICK && (client.ackTick == NET_NO_TICK || ack > client.ackTick))
+        {
+            client.ackTick = ack;
+        }
+        if (controls && input != client.input)
+        {
+            world.queueInput(input);
+        }
+        client.input = input;
+
+        // shots come in order and repeat until acknowledged; apply each once
+        for (std::uint32_t i = 0; i < shots; i++)
+        {
+            std::uint8_t kind = 0;
+            std::uint8_t bits = 0;
+            Vec2<float> target;
+            if (!in.get(kind) || !in.get(bits) || !in.get(target.x) || !in.get(target.y)) break;
+
+            const bool special = kind == static_cast<std::uint8_t>(World::PlayerAction::Kind::Special);
+            if (!special && kind != static_cast<std::uint8_t>(World::PlayerAction::Kind::Shot)) break;
+            if (special && bits >= static_cast<std::uint8_t>(World::SpecialWeapon::Count)) break;
+            if (firstShot + i != client.shotsApplied) continue;
+
+            if (controls && special)
+            {
+                world.queueSpecial(target, static_cast<World::SpecialWeapon>(bits));
+            }
+            else if (controls)
+            {
+                world.queueShot(target);
+            }
+            client.shotsApplied++;
+        }
+    }
+}
+
+void NetServer::broadcast(const World &world, float dt, double now)
+{
+    for (auto it = m_clients.begin(); it != m_clients.end();)
+    {
+        if (now - it->lastHeard > TIMEOUT)
+        {
+            std::cout << "Client " << it->address.toString() << " timed out\n";
+            it = m_clients.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    const auto tick = static_cast<std::uint32_t>(world.currentFrame());
+    const size_t slot = tick % HISTORY;
+    m_history[slot].capture(world, dt);
+    m_captured[slot] = true;
+
+    m_encodedCount = 0;
+    for (auto &client : m_clients)
+    {
+        const NetSnapshot *base = client.ackTick != tick ? snapshot(client.ackTick) : nullptr;
+        const std::uint32_t baseTick = base ? base->tick : NET_NO_TICK;
+
+        // A full snapshot of a big world is too many fragments to expect all
+        // of them through at once, so the same one goes out again while it
+        // is in the history and the client collects the pieces it missed.
+        const NetSnapshot *current = &m_history[slot];
+        if (base)
+        {
+            client.fullTick = NET_NO_TICK;
+        }
+        else if (const NetSnapshot *full = snapshot(client.fullTick))
+        {
+            current = full;
+        }
+        else
+        {
+            client.fullTick = tick;
+        }
+
+        // clients acking the same tick get the same bytes
+        auto first = m_encoded.begin();
+        auto last = first + static_cast<std::ptrdiff_t>(m_encodedCount);
+        auto encoded = std::find_if(first, last, [&](const Encoded &e)
+                                    { return e.tick == current->tick && e.baseline == baseTick; });
+        if (encoded == last)
+        {
+            if (m_encodedCount == m_encoded.size()) m_encoded.emplace_back();
+            encoded = m_encoded.begin() + static_cast<std::ptrdiff_t>(m_encodedCount++);
+            encoded->tick = current->tick;
+            encoded->baseline = baseTick;
+            encoded->data.clear();
+            encodeSnapshot(*current, base, encoded->data);
+        }
+        (base ? m_stats.deltaSnapshots : m_stats.fullSnapshots)++;
+
+        const auto &data = encoded->data;
+        const size_t count = std::max<size_t>(1, (data.size() + NET_FRAGMENT_PAYLOAD - 1) / NET_FRAGMENT_PAYLOAD);
+        if (count > 0xFFFF) continue;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const size_t offset = i * NET_FRAGMENT_PAYLOAD;
+            const size_t length = std::min(NET_FRAGMENT_PAYLOAD, data.size() - offset);
+
+            m_packet.clear();
+            ByteWriter out(m_packet);
+            out.put(NET_SNAPSHOT);
+            out.put(current->tick);
+            out.put(baseTick);
+            out.put(client.shotsApplied);
+            out.put(static_cast<std::uint16_t>(i));
+            out.put(static_cast<std::uint16_t>(count));
+            out.putBytes(data.data() + offset, length);
+
+            if (m_loss > 0.f && m_lossRng.uniform01() < m_loss) continue;
+            if (m_socket.send(client.address, m_packet.data(), m_packet.size()))
+            {
+                m_stats.bytesSent += m_packet.size();
+                m_stats.packetsSent++;
+            }
+        }
+    }
+}
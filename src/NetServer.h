@@ -0,0 +1,114 @@
+#pragma once
+
+#include "NetProtocol.h"
+#include "NetSnapshot.h"
+#include "NetSocket.h"
+#include "Random.hpp"
+#include "World.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// The authoritative end: applies client input to the world and sends every
+// client a snapshot delta-encoded against the last one it acknowledged. The
+// World has a single player, so the longest-connected client controls it
+// and the rest, up to the client limit, spectate.
+class NetServer
+{
+  public:
+    struct Stats
+    {
+        std::uint64_t bytesSent = 0;
+        std::uint64_t packetsSent = 0;
+        std::uint64_t fullSnapshots = 0;
+        std::uint64_t deltaSnapshots = 0;
+    };
+
+    static constexpr size_t DEFAULT_MAX_CLIENTS = 8;
+
+  private:
+    static constexpr size_t HISTORY = 64;
+    static constexpr double TIMEOUT = 5.0;
+
+    struct Client
+    {
+        NetAddress address;
+        std::uint32_t ackTick = NET_NO_TICK;
+        // the full snapshot being resent until the client has all of it
+        std::uint32_t fullTick = NET_NO_TICK;
+        std::uint32_t shotsApplied = 0;
+        std::uint8_t input = 0;
+        double lastHeard = 0.0;
+    };
+
+    struct Encoded
+    {
+        std::uint32_t tick = NET_NO_TICK;
+        std::uint32_t baseline = NET_NO_TICK;
+        std::vector<std::uint8_t> data;
+    };
+
+    UdpSocket m_socket;
+    std::vector<Client> m_clients;
+    // by tick % HISTORY
+    std::array<NetSnapshot, HISTORY> m_history;
+    std::array<bool, HISTORY> m_captured{};
+    // this broadcast's payloads, one per snapshot and baseline in use
+    std::vector<Encoded> m_encoded;
+    size_t m_encodedCount = 0;
+    std::vector<std::uint8_t> m_receive;
+    std::vector<std::uint8_t> m_packet;
+    Stats m_stats;
+    Rng m_lossRng;
+    float m_loss = 0.f;
+    size_t m_maxClients = DEFAULT_MAX_CLIENTS;
+    // keys the challenge tokens; new each time the server opens
+    std::uint64_t m_secret[2] = {};
+
+    std::uint64_t token(const NetAddress &address) const;
+    void challenge(const NetAddress &address);
+
+  public:
+    bool open(std::uint16_t port);
+
+    // Reads every waiting packet, answering connects with a challenge,
+    // taking on clients whose input carries their token while there is
+    // room, and queueing the controlling client's input and shots on world.
+    // now is in seconds.
+    void receive(World &world, double now);
+
+    // Captures the world and sends it to every client, dropping clients not
+    // heard from for TIMEOUT seconds. dt is the world's tick length.
+    void broadcast(const World &world, float dt, double now);
+
+    // The snapshot sent at tick, while it is still in the history.
+    const NetSnapshot *snapshot(std::uint32_t tick) const;
+
+    // Drops this fraction of outgoing packets, to test loss on loopback.
+    void setPacketLoss(float fraction)
+    {
+        m_loss = fraction;
+    }
+
+    // New clients past this many are ignored until one times out.
+    void setMaxClients(size_t count)
+    {
+        m_maxClients = count;
+    }
+
+    size_t clientCount() const
+    {
+        return m_clients.size();
+    }
+
+    const Stats &stats() const
+    {
+        return m_stats;
+    }
+
+    std::uint16_t port() const
+    {
+        return m_socket.port();
+    }
+};
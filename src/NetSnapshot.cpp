@@ -0,0 +1,602 @@
+#include "NetSnapshot.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr float POS_SCALE = 16.f;
+constexpr float TURN = 65536.f;
+// velocities carry a few more fractional bits than the values they advance,
+// so a prediction several ticks out stays within rounding of the real thing
+constexpr int VEL_FRACTION = 4;
+constexpr int ANG_VEL_FRACTION = 2;
+
+// which groups of an entity a delta carries
+constexpr std::uint8_t CHANGE_PARTS = 1;
+constexpr std::uint8_t CHANGE_POS = 2;
+constexpr std::uint8_t CHANGE_VEL = 4;
+constexpr std::uint8_t CHANGE_ANGLE = 8;
+constexpr std::uint8_t CHANGE_SHAPE = 16;
+constexpr std::uint8_t CHANGE_COLOR = 32;
+constexpr std::uint8_t CHANGE_ALPHA = 64;
+constexpr std::uint8_t CHANGE_SCORE = 128;
+constexpr int CHANGE_BITS = 8;
+// most updates are an entity drifting off its prediction; those get a 2-bit
+// mask instead of the full one
+constexpr std::uint8_t CHANGE_MOTION = CHANGE_POS | CHANGE_ANGLE;
+
+// LSB-first bit stream
+class BitWriter
+{
+    std::vector<std::uint8_t> &m_out;
+    std::uint64_t m_acc = 0;
+    int m_bits = 0;
+
+  public:
+    explicit BitWriter(std::vector<std::uint8_t> &out)
+        : m_out(out) {}
+
+    ~BitWriter()
+    {
+        if (m_bits > 0) m_out.push_back(static_cast<std::uint8_t>(m_acc));
+    }
+
+    void write(std::uint32_t value, int bits)
+    {
+        m_acc |= (static_cast<std::uint64_t>(value) & ((1ull << bits) - 1)) << m_bits;
+        m_bits += bits;
+        while (m_bits >= 8)
+        {
+            m_out.push_back(static_cast<std::uint8_t>(m_acc));
+            m_acc >>= 8;
+            m_bits -= 8;
+        }
+    }
+};
+
+class BitReader
+{
+    const std::uint8_t *m_p;
+    const std::uint8_t *m_end;
+    std::uint64_t m_acc = 0;
+    int m_bits = 0;
+    bool m_ok = true;
+
+  public:
+    BitReader(const std::uint8_t *data, size_t size)
+        : m_p(data), m_end(data + size) {}
+
+    std::uint32_t read(int bits)
+    {
+        while (m_bits < bits)
+        {
+            if (m_p == m_end)
+            {
+                m_ok = false;
+                return 0;
+            }
+            m_acc |= static_cast<std::uint64_t>(*m_p++) << m_bits;
+            m_bits += 8;
+        }
+        auto value = static_cast<std::uint32_t>(m_acc & ((1ull << bits) - 1));
+        m_acc >>= bits;
+        m_bits -= bits;
+        return value;
+    }
+
+    bool ok() const
+    {
+        return m_ok;
+    }
+};
+
+// 2-bit size class, then 4, 8, 16 or 32 bits
+void writeVar(BitWriter &w, std::uint32_t v)
+{
+    int size = v < (1u << 4) ? 0 : v < (1u << 8) ? 1 : v < (1u << 16) ? 2 : 3;
+    w.write(static_cast<std::uint32_t>(size), 2);
+    w.write(v, 4 << size);
+}
+
+std::uint32_t readVar(BitReader &r)
+{
+    return r.read(4 << r.read(2));
+}
+
+std::int32_t signExtend(std::uint32_t v, int bits)
+{
+    return static_cast<std::int32_t>(v << (32 - bits)) >> (32 - bits);
+}
+
+// A 16-bit value against its prediction, as a prefix code: exact (1 bit), a
+// 3-bit signed correction (4 bits, the usual rounding drift), an 8-bit one
+// (10 bits) or the value itself (18 bits). The correction wraps like the
+// value does.
+void writeResidual(BitWriter &w, std::uint16_t value, std::int32_t predicted)
+{
+    std::int32_t residual = static_cast<std::int16_t>(static_cast<std::uint16_t>(value - predicted));
+    if (residual == 0)
+    {
+        w.write(0, 1);
+    }
+    else if (residual >= -4 && residual < 4)
+    {
+        w.write(0b01, 2);
+        w.write(static_cast<std::uint32_t>(residual), 3);
+    }
+    else if (residual >= -128 && residual < 128)
+    {
+        w.write(0b011, 3);
+        w.write(static_cast<std::uint32_t>(residual), 8);
+    }
+    else
+    {
+        w.write(0b111, 3);
+        w.write(value, 16);
+    }
+}
+
+std::uint16_t readResidual(BitReader &r, std::int32_t predicted)
+{
+    if (!r.read(1)) return static_cast<std::uint16_t>(predicted);
+    if (!r.read(1)) return static_cast<std::uint16_t>(predicted + signExtend(r.read(3), 3));
+    if (!r.read(1)) return static_cast<std::uint16_t>(predicted + signExtend(r.read(8), 8));
+    return static_cast<std::uint16_t>(r.read(16));
+}
+
+std::int32_t predictX(const NetEntity &e, std::int32_t ticks)
+{
+    return e.x + ((e.vx * ticks + (1 << (VEL_FRACTION - 1))) >> VEL_FRACTION);
+}
+
+std::int32_t predictY(const NetEntity &e, std::int32_t ticks)
+{
+    return e.y + ((e.vy * ticks + (1 << (VEL_FRACTION - 1))) >> VEL_FRACTION);
+}
+
+std::int32_t predictAngle(const NetEntity &e, std::int32_t ticks)
+{
+    return e.angle + ((e.angVel * ticks + (1 << (ANG_VEL_FRACTION - 1))) >> ANG_VEL_FRACTION);
+}
+
+// what a baseline entity becomes after ticks with nothing sent about it
+NetEntity predict(const NetEntity &e, std::int32_t ticks)
+{
+    NetEntity p = e;
+    p.x = static_cast<std::uint16_t>(predictX(e, ticks));
+    p.y = static_cast<std::uint16_t>(predictY(e, ticks));
+    p.angle = static_cast<std::uint16_t>(predictAngle(e, ticks));
+    return p;
+}
+
+std::uint8_t changes(const NetEntity &e, const NetEntity &base, bool sameTag, std::int32_t ticks)
+{
+    std::uint8_t mask = 0;
+    if (e.parts != base.parts || !sameTag) mask |= CHANGE_PARTS;
+    if (e.parts & NetEntity::TRANSFORM)
+    {
+        if (e.x != static_cast<std::uint16_t>(predictX(base, ticks)) ||
+            e.y != static_cast<std::uint16_t>(predictY(base, ticks)))
+        {
+            mask |= CHANGE_POS;
+        }
+        if (e.vx != base.vx || e.vy != base.vy || e.angVel != base.angVel) mask |= CHANGE_VEL;
+        if (e.angle != static_cast<std::uint16_t>(predictAngle(base, ticks))) mask |= CHANGE_ANGLE;
+    }
+    if (e.parts & NetEntity::SHAPE)
+    {
+        if (e.points != base.points || e.radius != base.radius || e.thickness != base.thickness) mask |= CHANGE_SHAPE;
+        if ((e.fill >> 8) != (base.fill >> 8) || (e.outline >> 8) != (base.outline >> 8)) mask |= CHANGE_COLOR;
+        if ((e.fill & 0xFF) != (base.fill & 0xFF) || (e.outline & 0xFF) != (base.outline & 0xFF)) mask |= CHANGE_ALPHA;
+    }
+    if ((e.parts & NetEntity::SCORE) && e.score != base.score) mask |= CHANGE_SCORE;
+    return mask;
+}
+
+// Writes the groups in mask; a new entity is written with every group its
+// parts have, against an all-zero baseline.
+void writeEntity(BitWriter &w, const NetEntity &e, const NetEntity &base, std::uint8_t mask, std::int32_t ticks)
+{
+    if (mask & CHANGE_PARTS)
+    {
+        w.write(e.tag, 8);
+        w.write(e.parts, NetEntity::PART_BITS);
+    }
+    if (e.parts & NetEntity::TRANSFORM)
+    {
+        if (mask & CHANGE_POS)
+        {
+            writeResidual(w, e.x, predictX(base, ticks));
+            writeResidual(w, e.y, predictY(base, ticks));
+        }
+        if (mask & CHANGE_VEL)
+        {
+            w.write(static_cast<std::uint16_t>(e.vx), 16);
+            w.write(static_cast<std::uint16_t>(e.vy), 16);
+            w.write(static_cast<std::uint16_t>(e.angVel), 16);
+        }
+        if (mask & CHANGE_ANGLE) writeResidual(w, e.angle, predictAngle(base, ticks));
+    }
+    if (e.parts & NetEntity::SHAPE)
+    {
+        if (mask & CHANGE_SHAPE)
+        {
+            w.write(e.points, 8);
+            w.write(e.radius, 16);
+            w.write(e.thickness, 8);
+        }
+        if (mask & CHANGE_COLOR)
+        {
+            w.write(e.fill >> 8, 24);
+            w.write(e.outline >> 8, 24);
+        }
+        if (mask & CHANGE_ALPHA)
+        {
+            w.write(e.fill & 0xFF, 8);
+            w.write(e.outline & 0xFF, 8);
+        }
+    }
+    if ((e.parts & NetEntity::SCORE) && (mask & CHANGE_SCORE))
+    {
+        w.write(static_cast<std::uint32_t>(e.score), 32);
+    }
+}
+
+// e starts as the predicted baseline entity (or zeros) and is updated in place
+void readEntity(BitReader &r, NetEntity &e, const NetEntity &base, std::uint8_t mask, std::int32_t ticks)
+{
+    if (mask & CHANGE_PARTS)
+    {
+        e.tag = static_cast<std::uint8_t>(r.read(8));
+        e.parts = static_cast<std::uint8_t>(r.read(NetEntity::PART_BITS));
+    }
+    if (e.parts & NetEntity::TRANSFORM)
+    {
+        if (mask & CHANGE_POS)
+        {
+            e.x = readResidual(r, predictX(base, ticks));
+            e.y = readResidual(r, predictY(base, ticks));
+        }
+        if (mask & CHANGE_VEL)
+        {
+            e.vx = static_cast<std::int16_t>(r.read(16));
+            e.vy = static_cast<std::int16_t>(r.read(16));
+            e.angVel = static_cast<std::int16_t>(r.read(16));
+        }
+        if (mask & CHANGE_ANGLE) e.angle = readResidual(r, predictAngle(base, ticks));
+    }
+    if (e.parts & NetEntity::SHAPE)
+    {
+        if (mask & CHANGE_SHAPE)
+        {
+            e.points = static_cast<std::uint8_t>(r.read(8));
+            e.radius = static_cast<std::uint16_t>(r.read(16));
+            e.thickness = static_cast<std::uint8_t>(r.read(8));
+        }
+        if (mask & CHANGE_COLOR)
+        {
+            e.fill = (r.read(24) << 8) | (e.fill & 0xFF);
+            e.outline = (r.read(24) << 8) | (e.outline & 0xFF);
+        }
+        if (mask & CHANGE_ALPHA)
+        {
+            e.fill = (e.fill & ~0xFFu) | r.read(8);
+            e.outline = (e.outline & ~0xFFu) | r.read(8);
+        }
+    }
+    if ((e.parts & NetEntity::SCORE) && (mask & CHANGE_SCORE))
+    {
+        e.score = static_cast<std::int32_t>(r.read(32));
+    }
+}
+
+// every group present in a new entity
+std::uint8_t fullMask(const NetEntity &e)
+{
+    std::uint8_t mask = CHANGE_PARTS;
+    if (e.parts & NetEntity::TRANSFORM) mask |= CHANGE_POS | CHANGE_VEL | CHANGE_ANGLE;
+    if (e.parts & NetEntity::SHAPE) mask |= CHANGE_SHAPE | CHANGE_COLOR | CHANGE_ALPHA;
+    if (e.parts & NetEntity::SCORE) mask |= CHANGE_SCORE;
+    return mask;
+}
+
+std::uint16_t quantize(float v, float scale)
+{
+    return static_cast<std::uint16_t>(std::clamp(std::lround(v * scale), 0l, 65535l));
+}
+
+std::int16_t quantizeSigned(float v, float scale)
+{
+    return static_cast<std::int16_t>(std::clamp(std::lround(v * scale), -32768l, 32767l));
+}
+}
+
+void NetSnapshot::capture(const World &world, float dt)
+{
+    tick = static_cast<std::uint32_t>(world.currentFrame());
+    tags.clear();
+    entities.clear();
+
+    // tags are interned as the entity map's keys, so a tag is found by address
+    std::vector<const std::string *> tagKeys;
+    for (const auto &[tag, vec] : world.entities().getEntityMap())
+    {
+        tagKeys.push_back(&tag);
+        tags.push_back(tag);
+    }
+
+    const EntityVec &list = world.entities().getEntities();
+    entities.reserve(list.size());
+    for (Entity *e : list)
+    {
+        if (!e->isAlive()) continue;
+
+        NetEntity n;
+        n.id = static_cast<std::uint32_t>(e->id());
+        n.tag = static_cast<std::uint8_t>(std::find(tagKeys.begin(), tagKeys.end(), &e->tag()) - tagKeys.begin());
+        if (e->has<CTransform>())
+        {
+            const auto &t = e->get<CTransform>();
+            n.parts |= NetEntity::TRANSFORM;
+            n.x = quantize(t.pos.x, POS_SCALE);
+            n.y = quantize(t.pos.y, POS_SCALE);
+            n.vx = quantizeSigned(t.velocity.x * dt, POS_SCALE * (1 << VEL_FRACTION));
+            n.vy = quantizeSigned(t.velocity.y * dt, POS_SCALE * (1 << VEL_FRACTION));
+            n.angle = static_cast<std::uint16_t>(std::lround(t.angle / 360.f * TURN) & 0xFFFF);
+            n.angVel = quantizeSigned(t.angVel * dt / 360.f, TURN * (1 << ANG_VEL_FRACTION));
+        }
+        if (e->has<CShape>())
+        {
+            const auto &shape = e->get<CShape>();
+            n.parts |= NetEntity::SHAPE;
+            n.points = static_cast<std::uint8_t>(std::min<size_t>(shape.points, 255));
+            n.radius = quantize(shape.radius, POS_SCALE);
+            n.thickness = static_cast<std::uint8_t>(std::min<std::uint16_t>(quantize(shape.thickness, POS_SCALE), 255));
+            n.fill = shape.fill.toInteger();
+            n.outline = shape.outline.toInteger();
+        }
+        if (e->has<CScore>())
+        {
+            n.parts |= NetEntity::SCORE;
+            n.score = e->get<CScore>().score;
+        }
+        entities.push_back(n);
+    }
+}
+
+void NetSnapshot::apply(World &world) const
+{
+    const size_t n = entities.size();
+    std::vector<std::uint64_t> ids(n);
+    std::vector<std::uint16_t> tagIndex(n);
+    std::vector<std::uint8_t> alive(n, 1);
+    for (size_t i = 0; i < n; i++)
+    {
+        ids[i] = entities[i].id;
+        tagIndex[i] = entities[i].tag;
+    }
+
+    EntityManager &em = world.entities();
+    em.assign(n ? ids.back() + 1 : 0, tags, ids, tagIndex, alive, n);
+    const EntityVec &list = em.getEntities();
+    for (size_t i = 0; i < n; i++)
+    {
+        const NetEntity &ne = entities[i];
+        Entity *e = list[i];
+        if (ne.parts & NetEntity::TRANSFORM)
+        {
+            e->add<CTransform>(Vec2<float>(ne.x / POS_SCALE, ne.y / POS_SCALE), Vec2<float>(0.f, 0.f),
+                               ne.angle * 360.f / TURN, 0.f);
+        }
+        if (ne.parts & NetEntity::SHAPE)
+        {
+            e->add<CShape>(ne.radius / POS_SCALE, ne.points, sf::Color(ne.fill), sf::Color(ne.outline),
+                           ne.thickness / POS_SCALE);
+        }
+        if (ne.parts & NetEntity::SCORE)
+        {
+            e->add<CScore>(ne.score);
+        }
+    }
+}
+
+void NetSnapshot::lerp(const NetSnapshot &a, const NetSnapshot &b, float t, NetSnapshot &out)
+{
+    out.tick = b.tick;
+    out.tags = b.tags;
+    out.entities = b.entities;
+
+    size_t j = 0;
+    for (auto &e : out.entities)
+    {
+        while (j < a.entities.size() && a.entities[j].id < e.id) j++;
+        if (j == a.entities.size()) break;
+
+        const NetEntity &from = a.entities[j];
+        if (from.id != e.id || !(from.parts & e.parts & NetEntity::TRANSFORM)) continue;
+
+        e.x = static_cast<std::uint16_t>(std::lround(from.x + (e.x - from.x) * t));
+        e.y = static_cast<std::uint16_t>(std::lround(from.y + (e.y - from.y) * t));
+        auto turn = static_cast<std::int16_t>(static_cast<std::uint16_t>(e.angle - from.angle));
+        e.angle = static_cast<std::uint16_t>(from.angle + std::lround(turn * t));
+    }
+}
+
+void encodeSnapshot(const NetSnapshot &snapshot, const NetSnapshot *baseline, std::vector<std::uint8_t> &out)
+{
+    static const NetSnapshot empty;
+    const NetSnapshot &base = baseline ? *baseline : empty;
+    const std::int32_t ticks = static_cast<std::int32_t>(snapshot.tick - base.tick);
+
+    BitWriter w(out);
+    writeVar(w, static_cast<std::uint32_t>(snapshot.tags.size()));
+    for (const auto &tag : snapshot.tags)
+    {
+        writeVar(w, static_cast<std::uint32_t>(tag.size()));
+        for (char c : tag) w.write(static_cast<std::uint8_t>(c), 8);
+    }
+
+    // both lists are sorted by id, so one merge pass pairs them up
+    std::vector<std::uint32_t> removed;
+    struct Update
+    {
+        const NetEntity *entity;
+        const NetEntity *base;
+        std::uint8_t mask;
+    };
+    std::vector<Update> updates;
+    size_t j = 0;
+    for (const auto &e : snapshot.entities)
+    {
+        for (; j < base.entities.size() && base.entities[j].id < e.id; j++)
+        {
+            removed.push_back(base.entities[j].id);
+        }
+        if (j < base.entities.size() && base.entities[j].id == e.id)
+        {
+            const NetEntity &b = base.entities[j++];
+            bool sameTag = b.tag < base.tags.size() && e.tag < snapshot.tags.size() &&
+                           base.tags[b.tag] == snapshot.tags[e.tag];
+            if (std::uint8_t mask = changes(e, b, sameTag, ticks)) updates.push_back({&e, &b, mask});
+        }
+        else
+        {
+            updates.push_back({&e, nullptr, fullMask(e)});
+        }
+    }
+    for (; j < base.entities.size(); j++)
+    {
+        removed.push_back(base.entities[j].id);
+    }
+
+    writeVar(w, static_cast<std::uint32_t>(removed.size()));
+    std::uint32_t prev = 0;
+    for (std::uint32_t id : removed)
+    {
+        writeVar(w, id - prev);
+        prev = id;
+    }
+
+    static const NetEntity zero;
+    writeVar(w, static_cast<std::uint32_t>(updates.size()));
+    prev = 0;
+    for (const auto &u : updates)
+    {
+        writeVar(w, u.entity->id - prev);
+        prev = u.entity->id;
+        w.write(u.base != nullptr, 1);
+        if (u.base)
+        {
+            const bool motion = !(u.mask & ~CHANGE_MOTION);
+            w.write(motion, 1);
+            if (motion)
+            {
+                w.write((u.mask & CHANGE_POS) != 0, 1);
+                w.write((u.mask & CHANGE_ANGLE) != 0, 1);
+            }
+            else
+            {
+                w.write(u.mask, CHANGE_BITS);
+            }
+        }
+        writeEntity(w, *u.entity, u.base ? *u.base : zero, u.mask, ticks);
+    }
+}
+
+bool decodeSnapshot(const std::uint8_t *data, size_t size, const NetSnapshot *baseline, NetSnapshot &out)
+{
+    static const NetSnapshot empty;
+    const NetSnapshot &base = baseline ? *baseline : empty;
+    const std::int32_t ticks = static_cast<std::int32_t>(out.tick - base.tick);
+
+    BitReader r(data, size);
+    out.tags.resize(std::min<std::uint32_t>(readVar(r), 256));
+    for (auto &tag : out.tags)
+    {
+        tag.resize(std::min<std::uint32_t>(readVar(r), 256));
+        for (char &c : tag) c = static_cast<char>(r.read(8));
+    }
+
+    // baseline tag indices in terms of this snapshot's table
+    std::vector<std::uint8_t> remap(base.tags.size(), 0);
+    for (size_t i = 0; i < base.tags.size(); i++)
+    {
+        remap[i] = static_cast<std::uint8_t>(std::find(out.tags.begin(), out.tags.end(), base.tags[i]) - out.tags.begin());
+    }
+
+    std::vector<std::uint32_t> removed(std::min<std::uint32_t>(readVar(r), static_cast<std::uint32_t>(base.entities.size())));
+    std::uint32_t prev = 0;
+    for (auto &id : removed)
+    {
+        id = prev += readVar(r);
+    }
+
+    static const NetEntity zero;
+    std::vector<NetEntity> updates(std::min<std::uint32_t>(readVar(r), static_cast<std::uint32_t>(size * 8)));
+    prev = 0;
+    size_t j = 0;
+    for (auto &e : updates)
+    {
+        std::uint32_t id = prev += readVar(r);
+        if (r.read(1))
+        {
+            while (j < base.entities.size() && base.entities[j].id < id) j++;
+            if (j == base.entities.size() || base.entities[j].id != id) return false;
+
+            const NetEntity &b = base.entities[j];
+            std::uint8_t mask = 0;
+            if (r.read(1))
+            {
+                if (r.read(1)) mask |= CHANGE_POS;
+                if (r.read(1)) mask |= CHANGE_ANGLE;
+            }
+            else
+            {
+                mask = static_cast<std::uint8_t>(r.read(CHANGE_BITS));
+            }
+            e = predict(b, ticks);
+            e.tag = b.tag < remap.size() ? remap[b.tag] : 0;
+            readEntity(r, e, b, mask, ticks);
+        }
+        else
+        {
+            e = zero;
+            readEntity(r, e, zero, CHANGE_PARTS, ticks);
+            readEntity(r, e, zero, static_cast<std::uint8_t>(fullMask(e) & ~CHANGE_PARTS), ticks);
+        }
+        e.id = id;
+        if (!r.ok()) return false;
+    }
+
+    // the baseline, less what was removed, with the updates merged in
+    out.entities.clear();
+    out.entities.reserve(base.entities.size() + updates.size());
+    size_t k = 0;
+    size_t u = 0;
+    for (const auto &b : base.entities)
+    {
+        for (; u < updates.size() && updates[u].id < b.id; u++)
+        {
+            out.entities.push_back(updates[u]);
+        }
+        if (u < updates.size() && updates[u].id == b.id)
+        {
+            out.entities.push_back(updates[u++]);
+            continue;
+        }
+        while (k < removed.size() && removed[k] < b.id) k++;
+        if (k < removed.size() && removed[k] == b.id) continue;
+
+        NetEntity e = predict(b, ticks);
+        e.tag = b.tag < remap.size() ? remap[b.tag] : 0;
+        out.entities.push_back(e);
+    }
+    out.entities.insert(out.entities.end(), updates.begin() + static_cast<std::ptrdiff_t>(u), updates.end());
+
+    for (const auto &e : out.entities)
+    {
+        if (e.tag >= out.tags.size()) return false;
+    }
+    return r.ok();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+// World state as the network sees it: the live entities quantized to what a
+// client needs to draw them, and a bit-packed delta encoding of one snapshot
+// against an older one the client already has.
+
+#include "World.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct NetEntity
+{
+    // which of the groups below are present
+    static constexpr std::uint8_t TRANSFORM = 1;
+    static constexpr std::uint8_t SHAPE = 2;
+    static constexpr std::uint8_t SCORE = 4;
+    static constexpr int PART_BITS = 3;
+
+    std::uint32_t id = 0;
+    std::uint8_t tag = 0;
+    std::uint8_t parts = 0;
+
+    // position in 1/16 px and velocity in 1/256 px per tick; angle in 1/65536
+    // turns and angular velocity in 1/262144 turns per tick
+    std::uint16_t x = 0;
+    std::uint16_t y = 0;
+    std::int16_t vx = 0;
+    std::int16_t vy = 0;
+    std::uint16_t angle = 0;
+    std::int16_t angVel = 0;
+
+    // radius and outline thickness in 1/16 px, colours RGBA
+    std::uint8_t points = 0;
+    std::uint16_t radius = 0;
+    std::uint8_t thickness = 0;
+    std::uint32_t fill = 0;
+    std::uint32_t outline = 0;
+
+    std::int32_t score = 0;
+
+    bool operator==(const NetEntity &) const = default;
+};
+
+struct NetSnapshot
+{
+    std::uint32_t tick = 0;
+    std::vector<std::string> tags;
+    // ascending id
+    std::vector<NetEntity> entities;
+
+    bool operator==(const NetSnapshot &) const = default;
+
+    // dt is the world's tick length, which velocities are measured in.
+    void capture(const World &world, float dt);
+
+    // Replaces the world's entities with these, for drawing and inspecting;
+    // the world is not meant to be stepped afterwards.
+    void apply(World &world) const;
+
+    // Positions and angles blended a fraction t from a to b; everything else,
+    // and which entities exist, comes from b.
+    static void lerp(const NetSnapshot &a, const NetSnapshot &b, float t, NetSnapshot &out);
+};
+
+// Appends snapshot to out, as a delta against baseline if there is one. Each
+// entity's position and angle are predicted from the baseline's velocities,
+// and only entities that differ from that prediction are written, with just
+// the fields that differ; rounding drift takes 4 bits a field.
+void encodeSnapshot(const NetSnapshot &snapshot, const NetSnapshot *baseline, std::vector<std::uint8_t> &out);
+
+// Inverse of encodeSnapshot with the same baseline. out.tick must already be
+// set to the snapshot's tick.
+bool decodeSnapshot(const std::uint8_t *data, size_t size, const NetSnapshot *baseline, NetSnapshot &out);
@@ -0,0 +1,106 @@
+#include "NetSocket.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+// room for a few ticks of 10k-entity snapshots to every client
+constexpr int SOCKET_BUFFER = 4 << 20;
+
+sockaddr_in toSockaddr(const NetAddress &a)
+{
+    sockaddr_in sa{};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(a.host);
+    sa.sin_port = htons(a.port);
+    return sa;
+}
+}
+
+bool NetAddress::parse(const std::string &host, std::uint16_t port, NetAddress &out)
+{
+    in_addr addr{};
+    if (inet_pton(AF_INET, host == "localhost" ? "127.0.0.1" : host.c_str(), &addr) != 1)
+    {
+        return false;
+    }
+    out.host = ntohl(addr.s_addr);
+    out.port = port;
+    return true;
+}
+
+std::string NetAddress::toString() const
+{
+    return std::to_string(host >> 24) + "." + std::to_string((host >> 16) & 0xFF) + "." +
+           std::to_string((host >> 8) & 0xFF) + "." + std::to_string(host & 0xFF) + ":" + std::to_string(port);
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+bool UdpSocket::open(std::uint16_t port)
+{
+    close();
+
+    m_fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (m_fd < 0)
+    {
+        std::cerr << "Error: Could not create socket: " << std::strerror(errno) << "\n";
+        return false;
+    }
+    ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+    ::setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &SOCKET_BUFFER, sizeof(SOCKET_BUFFER));
+    ::setsockopt(m_fd, SOL_SOCKET, SO_SNDBUF, &SOCKET_BUFFER, sizeof(SOCKET_BUFFER));
+
+    sockaddr_in sa = toSockaddr({INADDR_ANY, port});
+    socklen_t len = sizeof(sa);
+    if (::bind(m_fd, reinterpret_cast<sockaddr *>(&sa), len) != 0 ||
+        ::getsockname(m_fd, reinterpret_cast<sockaddr *>(&sa), &len) != 0)
+    {
+        std::cerr << "Error: Could not bind UDP port " << port << ": " << std::strerror(errno) << "\n";
+        close();
+        return false;
+    }
+    m_port = ntohs(sa.sin_port);
+    return true;
+}
+
+void UdpSocket::close()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool UdpSocket::send(const NetAddress &to, const void *data, size_t size)
+{
+    sockaddr_in sa = toSockaddr(to);
+    return ::sendto(m_fd, data, size, 0, reinterpret_cast<sockaddr *>(&sa), sizeof(sa)) ==
+           static_cast<ssize_t>(size);
+}
+
+bool UdpSocket::receive(NetAddress &from, void *buffer, size_t capacity, size_t &size)
+{
+    sockaddr_in sa{};
+    socklen_t len = sizeof(sa);
+    ssize_t n = ::recvfrom(m_fd, buffer, capacity, 0, reinterpret_cast<sockaddr *>(&sa), &len);
+    if (n < 0)
+    {
+        return false;
+    }
+    size = static_cast<size_t>(n);
+    from.host = ntohl(sa.sin_addr.s_addr);
+    from.port = ntohs(sa.sin_port);
+    return true;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// IPv4 address and port, both in host byte order.
+struct NetAddress
+{
+    std::uint32_t host = 0;
+    std::uint16_t port = 0;
+
+    bool operator==(const NetAddress &) const = default;
+
+    // Accepts dotted quads and "localhost".
+    static bool parse(const std::string &host, std::uint16_t port, NetAddress &out);
+    std::string toString() const;
+};
+
+// Non-blocking UDP socket (POSIX).
+class UdpSocket
+{
+    int m_fd = -1;
+    std::uint16_t m_port = 0;
+
+  public:
+    // the largest UDP payload over IPv4
+    static constexpr size_t MAX_DATAGRAM = 65507;
+
+    UdpSocket() = default;
+    ~UdpSocket();
+
+    UdpSocket(const UdpSocket &) = delete;
+    UdpSocket &operator=(const UdpSocket &) = delete;
+
+    // Binds to port on every interface; 0 picks a free one. Prints the
+    // reason and returns false on failure.
+    bool open(std::uint16_t port);
+    void close();
+
+    // Datagrams that don't fit the send buffer are dropped, as UDP may.
+    bool send(const NetAddress &to, const void *data, size_t size);
+
+    // Takes the next waiting datagram into buffer, truncated to capacity;
+    // false when there is none. MAX_DATAGRAM always fits a whole one.
+    bool receive(NetAddress &from, void *buffer, size_t capacity, size_t &size);
+
+    bool isOpen() const
+    {
+        return m_fd >= 0;
+    }
+
+    std::uint16_t port() const
+    {
+        return m_port;
+    }
+};
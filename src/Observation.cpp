@@ -0,0 +1,105 @@
+#include "Observation.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace
+{
+// tags in ObservationGrid::Channel order
+constexpr std::array<const char *, ObservationGrid::Channels> CHANNEL_TAGS = {"player", "enemy", "smallEnemy",
+                                                                              "bullet"};
+}
+
+void ObservationGrid::write(const World &world, std::span<float> out) const
+{
+    if (out.size() < size()) return;
+
+    const size_t plane = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+    std::fill(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(size()), 0.f);
+
+    const Vec2<float> &bounds = world.bounds();
+    const float sx = static_cast<float>(m_width) / bounds.x;
+    const float sy = static_cast<float>(m_height) / bounds.y;
+
+    for (int channel = 0; channel < Channels; channel++)
+    {
+        float *cells = out.data() + static_cast<size_t>(channel) * plane;
+        for (Entity *e : world.entities().getEntities(CHANNEL_TAGS[static_cast<size_t>(channel)]))
+        {
+            if (!e->isAlive() || !e->has<CTransform>() || !e->has<CCollision>()) continue;
+
+            // in cell units; cell (i, j) has its centre at (i + 0.5, j + 0.5)
+            const Vec2<float> &pos = e->get<CTransform>().pos;
+            const float radius = e->get<CCollision>().radius;
+            const float cx = pos.x * sx;
+            const float cy = pos.y * sy;
+            const float rx = radius * sx;
+            const float ry = radius * sy;
+
+            const int centreX = static_cast<int>(std::floor(cx));
+            const int centreY = static_cast<int>(std::floor(cy));
+            if (centreX >= 0 && centreX < m_width && centreY >= 0 && centreY < m_height)
+            {
+                cells[static_cast<size_t>(centreY) * static_cast<size_t>(m_width) + static_cast<size_t>(centreX)] = 1.f;
+            }
+
+            // one solid span per row the circle covers; the spans are plain
+            // fills, which the compiler turns into vector stores
+            const int y0 = std::max(0, static_cast<int>(std::ceil(cy - ry - 0.5f)));
+            const int y1 = std::min(m_height - 1, static_cast<int>(std::floor(cy + ry - 0.5f)));
+            for (int y = y0; y <= y1; y++)
+            {
+                const float dy = (static_cast<float>(y) + 0.5f - cy) / ry;
+                const float half = rx * std::sqrt(std::max(0.f, 1.f - dy * dy));
+                const int x0 = std::max(0, static_cast<int>(std::ceil(cx - half - 0.5f)));
+                const int x1 = std::min(m_width - 1, static_cast<int>(std::floor(cx + half - 0.5f)));
+                if (x0 > x1) continue;
+
+                float *row = cells + static_cast<size_t>(y) * static_cast<size_t>(m_width);
+                std::fill(row + x0, row + x1 + 1, 1.f);
+            }
+        }
+    }
+}
+
+void ObservationNearest::write(const World &world, std::span<float> out)
+{
+    if (out.size() < size()) return;
+    std::fill(out.begin(), out.begin() + static_cast<std::ptrdiff_t>(size()), 0.f);
+
+    const EntityManager &em = world.entities();
+    const EntityVec &players = em.getEntities("player");
+    if (players.empty() || !players.back()->has<CTransform>()) return;
+    const Vec2<float> origin = players.back()->get<CTransform>().pos;
+
+    m_scratch.clear();
+    for (int kind = 0; kind < 3; kind++)
+    {
+        for (Entity *e : em.getEntities(CHANNEL_TAGS[static_cast<size_t>(ObservationGrid::Enemy + kind)]))
+        {
+            if (!e->isAlive() || !e->has<CTransform>()) continue;
+
+            const Vec2<float> d = e->get<CTransform>().pos - origin;
+            m_scratch.push_back({d.x * d.x + d.y * d.y, e, kind});
+        }
+    }
+
+    const size_t n = std::min(m_count, m_scratch.size());
+    auto nearer = [](const Candidate &a, const Candidate &b) { return a.dist2 < b.dist2; };
+    std::partial_sort(m_scratch.begin(), m_scratch.begin() + static_cast<std::ptrdiff_t>(n), m_scratch.end(), nearer);
+
+    const Vec2<float> &bounds = world.bounds();
+    for (size_t i = 0; i < n; i++)
+    {
+        const Candidate &c = m_scratch[i];
+        const auto &t = c.entity->get<CTransform>();
+        float *f = out.data() + i * FEATURES;
+        f[0] = (t.pos.x - origin.x) / bounds.x;
+        f[1] = (t.pos.y - origin.y) / bounds.y;
+        f[2] = t.velocity.x / bounds.x;
+        f[3] = t.velocity.y / bounds.y;
+        f[4] = c.entity->has<CCollision>() ? c.entity->get<CCollision>().radius / bounds.x : 0.f;
+        f[5 + c.kind] = 1.f;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// Compact views of a World for training, written straight into memory the
+// caller owns (a tensor's storage, say) so nothing is copied on the way out.
+// Both are far cheaper than drawing a frame and reading it back: a grid
+// touches only the cells entities cover, and nearest-K only the entities.
+
+#include "World.h"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+// A low-resolution occupancy image with one channel per kind of entity,
+// laid out channel, row, column. A cell is 1 where its centre lies inside an
+// entity's collision circle; an entity smaller than a cell still marks the
+// cell its centre is in.
+class ObservationGrid
+{
+    int m_width;
+    int m_height;
+
+  public:
+    enum Channel
+    {
+        Player,
+        Enemy,
+        SmallEnemy,
+        Bullet,
+        Channels
+    };
+
+    ObservationGrid(int width = 64, int height = 36)
+        : m_width(width), m_height(height) {}
+
+    int width() const
+    {
+        return m_width;
+    }
+
+    int height() const
+    {
+        return m_height;
+    }
+
+    // floats per world
+    size_t size() const
+    {
+        return static_cast<size_t>(Channels) * static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+    }
+
+    // out must hold size() floats.
+    void write(const World &world, std::span<float> out) const;
+};
+
+// The count entities nearest the player, closest first, FEATURES floats each:
+// offset from the player and velocity (both as fractions of the world size,
+// velocity per second), collision radius (likewise), and a one-hot kind of
+// enemy, small enemy or bullet. Missing entries are all zero.
+class ObservationNearest
+{
+    struct Candidate
+    {
+        float dist2;
+        Entity *entity;
+        int kind;
+    };
+
+    size_t m_count;
+    std::vector<Candidate> m_scratch;
+
+  public:
+    static constexpr size_t FEATURES = 8;
+
+    explicit ObservationNearest(size_t count = 16)
+        : m_count(count) {}
+
+    size_t count() const
+    {
+        return m_count;
+    }
+
+    // floats per world
+    size_t size() const
+    {
+        return m_count * FEATURES;
+    }
+
+    // out must hold size() floats.
+    void write(const World &world, std::span<float> out);
+};
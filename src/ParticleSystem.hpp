@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Bytes.hpp"
+#include "Random.hpp"
+#include "Vec2.hpp"
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Describes one emission: count particles leave pos with baseVel plus a
+// random radial velocity in [speedMin, speedMax].
+struct ParticleBurst
+{
+    Vec2<float> pos;
+    Vec2<float> baseVel;
+    float speedMin = 0.f;
+    float speedMax = 0.f;
+    float lifeMin = 0.f;
+    float lifeMax = 0.f;
+    sf::Color color = sf::Color::White;
+};
+
+// Cosmetic particles kept out of the ECS. Each attribute lives in its own
+// array so update() is a handful of straight loops the compiler vectorizes,
+// and dead particles are compacted by swapping the last live one into place.
+class ParticleSystem
+{
+    std::vector<float> m_posX;
+    std::vector<float> m_posY;
+    std::vector<float> m_velX;
+    std::vector<float> m_velY;
+    std::vector<float> m_age;
+    std::vector<float> m_life;
+    std::vector<sf::Color> m_color;
+    std::vector<sf::Vertex> m_vertices;
+    size_t m_count = 0;
+    size_t m_capacity = 0;
+    float m_size = 2.f;
+    Rng m_rng;
+
+    void kill(size_t i)
+    {
+        size_t last = --m_count;
+        m_posX[i] = m_posX[last];
+        m_posY[i] = m_posY[last];
+        m_velX[i] = m_velX[last];
+        m_velY[i] = m_velY[last];
+        m_age[i] = m_age[last];
+        m_life[i] = m_life[last];
+        m_color[i] = m_color[last];
+    }
+
+  public:
+    ParticleSystem() = default;
+
+    void reserve(size_t capacity, float size)
+    {
+        m_capacity = capacity;
+        m_size = size;
+        m_posX.resize(capacity);
+        m_posY.resize(capacity);
+        m_velX.resize(capacity);
+        m_velY.resize(capacity);
+        m_age.resize(capacity);
+        m_life.resize(capacity);
+        m_color.resize(capacity);
+        m_vertices.resize(capacity * 3);
+        m_count = std::min(m_count, capacity);
+    }
+
+    void seed(const Rng &rng)
+    {
+        m_rng = rng;
+    }
+
+    // Emits up to count particles, silently dropping whatever does not fit.
+    void emit(const ParticleBurst &burst, size_t count)
+    {
+        // random angles, speeds and lifetimes are drawn a chunk at a time
+        constexpr size_t CHUNK = 64;
+        std::array<float, CHUNK> angle;
+        std::array<float, CHUNK> speed;
+        std::array<float, CHUNK> life;
+
+        size_t end = std::min(m_count + count, m_capacity);
+        for (size_t base = m_count; base < end; base += CHUNK)
+        {
+            size_t n = std::min(CHUNK, end - base);
+            m_rng.fillUniform(std::span(angle.data(), n), 0.f, 6.2831853f);
+            m_rng.fillUniform(std::span(speed.data(), n), burst.speedMin, burst.speedMax);
+            m_rng.fillUniform(std::span(life.data(), n), burst.lifeMin, burst.lifeMax);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                size_t i = base + j;
+                m_posX[i] = burst.pos.x;
+                m_posY[i] = burst.pos.y;
+                m_velX[i] = burst.baseVel.x + std::cos(angle[j]) * speed[j];
+                m_velY[i] = burst.baseVel.y + std::sin(angle[j]) * speed[j];
+                m_age[i] = 0.f;
+                m_life[i] = life[j];
+                m_color[i] = burst.color;
+            }
+        }
+        m_count = end;
+    }
+
+    void update(float dt)
+    {
+        const size_t n = m_count;
+        float *__restrict px = m_posX.data();
+        float *__restrict py = m_posY.data();
+        float *__restrict vx = m_velX.data();
+        float *__restrict vy = m_velY.data();
+        float *__restrict age = m_age.data();
+
+        for (size_t i = 0; i < n; i++)
+        {
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            age[i] += dt;
+        }
+
+        // compact: swap the last live particle into each dead slot
+        size_t i = 0;
+        while (i < m_count)
+        {
+            if (m_age[i] >= m_life[i])
+            {
+                kill(i);
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+
+    // Fills the shared vertex buffer with one faded triangle per particle and
+    // returns the number of vertices to draw.
+    size_t buildVertices()
+    {
+        const float s = m_size;
+        for (size_t i = 0; i < m_count; i++)
+        {
+            sf::Color c = m_color[i];
+            float ratio = 1.f - m_age[i] / m_life[i];
+            c.a = static_cast<std::uint8_t>(c.a * std::clamp(ratio, 0.f, 1.f));
+
+            sf::Vertex *v = &m_vertices[i * 3];
+            v[0].position = {m_posX[i], m_posY[i] - s};
+            v[1].position = {m_posX[i] - s, m_posY[i] + s};
+            v[2].position = {m_posX[i] + s, m_posY[i] + s};
+            v[0].color = v[1].color = v[2].color = c;
+        }
+        return m_count * 3;
+    }
+
+    const sf::Vertex *vertices() const
+    {
+        return m_vertices.data();
+    }
+
+    size_t size() const
+    {
+        return m_count;
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    void clear()
+    {
+        m_count = 0;
+    }
+
+    // The live prefix of every attribute array plus the random stream.
+    struct Snapshot
+    {
+        std::vector<float> posX;
+        std::vector<float> posY;
+        std::vector<float> velX;
+        std::vector<float> velY;
+        std::vector<float> age;
+        std::vector<float> life;
+        std::vector<sf::Color> color;
+        Rng rng;
+
+        void reserve(size_t n)
+        {
+            for (auto *v : {&posX, &posY, &velX, &velY, &age, &life}) v->reserve(n);
+            color.reserve(n);
+        }
+
+        // heap held, including capacity not in use
+        size_t bytes() const
+        {
+            size_t total = color.capacity() * sizeof(sf::Color);
+            for (const auto *v : {&posX, &posY, &velX, &velY, &age, &life}) total += v->capacity() * sizeof(float);
+            return total;
+        }
+    };
+
+    void capture(Snapshot &s) const
+    {
+        const size_t n = m_count;
+        s.posX.assign(m_posX.begin(), m_posX.begin() + n);
+        s.posY.assign(m_posY.begin(), m_posY.begin() + n);
+        s.velX.assign(m_velX.begin(), m_velX.begin() + n);
+        s.velY.assign(m_velY.begin(), m_velY.begin() + n);
+        s.age.assign(m_age.begin(), m_age.begin() + n);
+        s.life.assign(m_life.begin(), m_life.begin() + n);
+        s.color.assign(m_color.begin(), m_color.begin() + n);
+        s.rng = m_rng;
+    }
+
+    void restore(const Snapshot &s)
+    {
+        const size_t n = std::min(s.posX.size(), m_capacity);
+        std::copy_n(s.posX.begin(), n, m_posX.begin());
+        std::copy_n(s.posY.begin(), n, m_posY.begin());
+        std::copy_n(s.velX.begin(), n, m_velX.begin());
+        std::copy_n(s.velY.begin(), n, m_velY.begin());
+        std::copy_n(s.age.begin(), n, m_age.begin());
+        std::copy_n(s.life.begin(), n, m_life.begin());
+        std::copy_n(s.color.begin(), n, m_color.begin());
+        m_count = n;
+        m_rng = s.rng;
+    }
+
+    void save(ByteWriter &out) const
+    {
+        out.put(m_rng.state());
+        out.putVarint(m_count);
+        out.putBytes(m_posX.data(), m_count * sizeof(float));
+        out.putBytes(m_posY.data(), m_count * sizeof(float));
+        out.putBytes(m_velX.data(), m_count * sizeof(float));
+        out.putBytes(m_velY.data(), m_count * sizeof(float));
+        out.putBytes(m_age.data(), m_count * sizeof(float));
+        out.putBytes(m_life.data(), m_count * sizeof(float));
+        out.putBytes(m_color.data(), m_count * sizeof(sf::Color));
+    }
+
+    // Fails if the data is malformed or holds more particles than fit.
+    bool load(ByteReader &in)
+    {
+        std::array<std::uint64_t, 4> state;
+        std::uint64_t count = 0;
+        if (!in.get(state) || !in.getVarint(count) || count > m_capacity) return false;
+
+        const size_t n = static_cast<size_t>(count);
+        bool ok = in.getBytes(m_posX.data(), n * sizeof(float)) && in.getBytes(m_posY.data(), n * sizeof(float)) &&
+                  in.getBytes(m_velX.data(), n * sizeof(float)) && in.getBytes(m_velY.data(), n * sizeof(float)) &&
+                  in.getBytes(m_age.data(), n * sizeof(float)) && in.getBytes(m_life.data(), n * sizeof(float)) &&
+                  in.getBytes(m_color.data(), n * sizeof(sf::Color));
+        m_count = ok ? n : 0;
+        m_rng.setState(state);
+        return ok;
+    }
+};
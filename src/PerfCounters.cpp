@@ -0,0 +1,164 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::tuple_size_v<decltype(PerfSample::counts)> == PerfCounters::Count);
+
+const char *PerfCounters::name(Counter counter)
+{
+    switch (counter)
+    {
+        case Cycles: return "cycles";
+        case Instructions: return "instructions";
+        case L1DMisses: return "l1d_misses";
+        case LLCMisses: return "llc_misses";
+        case BranchMisses: return "branch_misses";
+        default: return "unknown";
+    }
+}
+
+PerfCounters::PerfCounters()
+{
+    m_fds.fill(-1);
+    m_slots.fill(-1);
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+#ifdef __linux__
+
+static int openEvent(std::uint32_t type, std::uint64_t config, int group)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+bool PerfCounters::open()
+{
+    close();
+
+    struct EventConfig
+    {
+        std::uint32_t type;
+        std::uint64_t config;
+    };
+    const std::array<EventConfig, Count> events = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                             (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    }};
+
+    // the first counter that opens leads the group; the rest join it
+    int leader = -1;
+    for (int i = 0; i < Count; i++)
+    {
+        int fd = openEvent(events[i].type, events[i].config, leader);
+        if (fd < 0)
+        {
+            if (m_error.empty()) m_error = std::string(name(static_cast<Counter>(i))) + ": " + std::strerror(errno);
+            continue;
+        }
+        if (leader == -1) leader = fd;
+        m_fds[i] = fd;
+        m_slots[i] = m_opened++;
+    }
+
+    if (leader == -1)
+    {
+        m_error = "perf_event_open failed (" + m_error + ")";
+        return false;
+    }
+    if (!m_error.empty())
+    {
+        m_error = "some counters unavailable (" + m_error + ")";
+    }
+
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close()
+{
+    for (int &fd : m_fds)
+    {
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+    m_slots.fill(-1);
+    m_opened = 0;
+    m_error.clear();
+}
+
+PerfSample PerfCounters::read() const
+{
+    PerfSample sample;
+    if (m_opened == 0) return sample;
+
+    int leader = -1;
+    for (int fd : m_fds)
+    {
+        if (fd >= 0)
+        {
+            leader = fd;
+            break;
+        }
+    }
+
+    // nr, time enabled, time running, then one value per counter
+    std::array<std::uint64_t, 3 + Count> buffer{};
+    if (::read(leader, buffer.data(), sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(std::uint64_t)))
+    {
+        return sample;
+    }
+
+    double scale = buffer[2] > 0 ? static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]) : 1.0;
+    for (int i = 0; i < Count; i++)
+    {
+        if (m_slots[i] < 0) continue;
+        sample.counts[i] = static_cast<std::uint64_t>(static_cast<double>(buffer[3 + m_slots[i]]) * scale);
+    }
+    return sample;
+}
+
+#else
+
+bool PerfCounters::open()
+{
+    m_error = "hardware counters need Linux perf_event_open";
+    return false;
+}
+
+void PerfCounters::close()
+{
+    m_slots.fill(-1);
+    m_opened = 0;
+}
+
+PerfSample PerfCounters::read() const
+{
+    return {};
+}
+
+#endif
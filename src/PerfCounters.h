@@ -0,0 +1,85 @@
+#pragma once
+
+// Hardware performance counters for the calling thread, read as one
+// perf_event_open group so every counter covers exactly the same code.
+// Other threads, a ThreadPool's workers among them, are not counted:
+// inherited counters only add a child's counts once it exits.
+// Linux only; elsewhere, or when the kernel refuses (perf_event_paranoid,
+// containers, VMs without a PMU), open() fails with a reason and callers
+// carry on without counters. Counters the CPU doesn't support are left out
+// of the group and report as unavailable.
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+struct PerfSample
+{
+    std::array<std::uint64_t, 5> counts{};
+
+    PerfSample &operator+=(const PerfSample &other)
+    {
+        for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+        return *this;
+    }
+
+    PerfSample operator-(const PerfSample &other) const
+    {
+        PerfSample d;
+        for (size_t i = 0; i < counts.size(); i++) d.counts[i] = counts[i] - other.counts[i];
+        return d;
+    }
+};
+
+class PerfCounters
+{
+  public:
+    enum Counter
+    {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        BranchMisses,
+        Count
+    };
+
+    static const char *name(Counter counter);
+
+  private:
+    std::array<int, Count> m_fds;
+    std::array<int, Count> m_slots;
+    int m_opened = 0;
+    std::string m_error;
+
+  public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    // Opens and starts the group for the calling thread. Returns false, with
+    // error() saying why, if no counters could be opened.
+    bool open();
+    void close();
+
+    bool available() const
+    {
+        return m_opened > 0;
+    }
+
+    bool has(Counter counter) const
+    {
+        return m_slots[counter] >= 0;
+    }
+
+    const std::string &error() const
+    {
+        return m_error;
+    }
+
+    // Running totals since open(), scaled up if the kernel had to multiplex
+    // the group. Subtract two reads to measure a region.
+    PerfSample read() const;
+};
@@ -0,0 +1,185 @@
+#include "PolygonCollider.h"
+
+#include <array>
+#include <cmath>
+
+namespace
+{
+constexpr float PI = 3.14159265f;
+constexpr size_t N = PolygonCollider::MAX_POINTS;
+constexpr size_t AXES = 2 * N;
+
+using Lanes = std::array<float, N>;
+using AxisLanes = std::array<float, AXES>;
+
+// Corners and edge normals of a polygon, padded to N by repeating them.
+// Repeats change neither the extent along an axis nor the set of axes.
+struct Polygon
+{
+    Lanes x;
+    Lanes y;
+    Lanes nx;
+    Lanes ny;
+};
+
+// Sine and cosine of an angle in degrees. Hit tests feed kills and score,
+// which the world hash covers, so this is a fixed polynomial rather than
+// libm, whose last bits differ between platforms. fmod and floor are exact,
+// and the rest is plain arithmetic built without contraction, so every
+// machine gets the same bits. Within 3e-7 of the true values.
+void sinCosDegrees(float degrees, float &s, float &c)
+{
+    float d = std::fmod(degrees, 360.f);
+    if (d < 0.f) d += 360.f;
+
+    // the nearest quarter turn, leaving at most 45 degrees for the series
+    const float quarter = std::floor(d / 90.f + 0.5f);
+    const float x = (d - quarter * 90.f) * (PI / 180.f);
+    const float x2 = x * x;
+    const float sp = x * (1.f + x2 * (-1.f / 6.f + x2 * (1.f / 120.f + x2 * (-1.f / 5040.f + x2 * (1.f / 362880.f)))));
+    const float cp = 1.f + x2 * (-0.5f + x2 * (1.f / 24.f + x2 * (-1.f / 720.f + x2 * (1.f / 40320.f))));
+    switch (static_cast<int>(quarter) & 3)
+    {
+    case 0: s = sp; c = cp; break;
+    case 1: s = cp; c = -sp; break;
+    case 2: s = -sp; c = -cp; break;
+    default: s = -cp; c = sp; break;
+    }
+}
+
+// The polygon of circumradius 1 at angle 0 for each point count.
+const Polygon &unitPolygon(size_t points)
+{
+    static const auto table = []
+    {
+        std::array<Polygon, N + 1> t{};
+        for (size_t n = 3; n <= N; n++)
+        {
+            for (size_t i = 0; i < N; i++)
+            {
+                const float a = static_cast<float>(i % n) * 360.f / static_cast<float>(n) - 90.f;
+                const float normal = a + 180.f / static_cast<float>(n);
+                sinCosDegrees(a, t[n].y[i], t[n].x[i]);
+                sinCosDegrees(normal, t[n].ny[i], t[n].nx[i]);
+            }
+        }
+        return t;
+    }();
+    return table[points];
+}
+
+// The shape as drawn, with its centre at (cx, cy).
+void place(const CShape &shape, const CTransform &t, float cx, float cy, Polygon &__restrict out)
+{
+    const Polygon &__restrict unit = unitPolygon(shape.points);
+    float sn = 0.f;
+    float cs = 1.f;
+    sinCosDegrees(t.angle, sn, cs);
+    const float r = shape.radius;
+    for (size_t i = 0; i < N; i++)
+    {
+        out.x[i] = cx + (unit.x[i] * cs - unit.y[i] * sn) * r;
+        out.y[i] = cy + (unit.x[i] * sn + unit.y[i] * cs) * r;
+        out.nx[i] = unit.nx[i] * cs - unit.ny[i] * sn;
+        out.ny[i] = unit.nx[i] * sn + unit.ny[i] * cs;
+    }
+}
+
+// The extent of a polygon's N corners along every axis.
+void project(const float *__restrict px, const float *__restrict py, const float *__restrict ax,
+             const float *__restrict ay, float *__restrict lo, float *__restrict hi)
+{
+    for (size_t k = 0; k < AXES; k++)
+    {
+        lo[k] = hi[k] = px[0] * ax[k] + py[0] * ay[k];
+    }
+    for (size_t i = 1; i < N; i++)
+    {
+        for (size_t k = 0; k < AXES; k++)
+        {
+            const float d = px[i] * ax[k] + py[i] * ay[k];
+            lo[k] = d < lo[k] ? d : lo[k];
+            hi[k] = d > hi[k] ? d : hi[k];
+        }
+    }
+}
+}
+
+bool PolygonCollider::overlaps(const CShape &sa, const CTransform &ta, const CShape &sb, const CTransform &tb)
+{
+    // a is the polygon from here on
+    if (!isPolygon(sa))
+    {
+        return isPolygon(sb) ? overlaps(sb, tb, sa, ta) : true;
+    }
+
+    // everything relative to a's centre, which keeps the projections small
+    const float bx = tb.pos.x - ta.pos.x;
+    const float by = tb.pos.y - ta.pos.y;
+    Polygon a;
+    place(sa, ta, 0.f, 0.f, a);
+
+    AxisLanes ax;
+    AxisLanes ay;
+    AxisLanes loA;
+    AxisLanes hiA;
+    AxisLanes loB;
+    AxisLanes hiB;
+    for (size_t i = 0; i < N; i++)
+    {
+        ax[i] = a.nx[i];
+        ay[i] = a.ny[i];
+    }
+
+    if (isPolygon(sb))
+    {
+        Polygon b;
+        place(sb, tb, bx, by, b);
+        for (size_t i = 0; i < N; i++)
+        {
+            ax[N + i] = b.nx[i];
+            ay[N + i] = b.ny[i];
+        }
+        project(b.x.data(), b.y.data(), ax.data(), ay.data(), loB.data(), hiB.data());
+    }
+    else
+    {
+        // a circle adds one axis, toward the polygon's nearest corner; at
+        // zero length it separates nothing, which is right for a centre
+        // sitting on the corner
+        size_t nearest = 0;
+        float best = INFINITY;
+        for (size_t i = 0; i < N; i++)
+        {
+            const float d2 = (a.x[i] - bx) * (a.x[i] - bx) + (a.y[i] - by) * (a.y[i] - by);
+            if (d2 < best)
+            {
+                best = d2;
+                nearest = i;
+            }
+        }
+        const float len = std::sqrt(best);
+        const float dx = len > 0.f ? (a.x[nearest] - bx) / len : 0.f;
+        const float dy = len > 0.f ? (a.y[nearest] - by) / len : 0.f;
+        for (size_t i = 0; i < N; i++)
+        {
+            ax[N + i] = dx;
+            ay[N + i] = dy;
+        }
+        for (size_t k = 0; k < AXES; k++)
+        {
+            const float c = bx * ax[k] + by * ay[k];
+            loB[k] = c - sb.radius;
+            hiB[k] = c + sb.radius;
+        }
+    }
+    project(a.x.data(), a.y.data(), ax.data(), ay.data(), loA.data(), hiA.data());
+
+    // touching counts, as it does for circles
+    int separated = 0;
+    for (size_t k = 0; k < AXES; k++)
+    {
+        separated |= (hiA[k] < loB[k]) | (hiB[k] < loA[k]);
+    }
+    return separated == 0;
+}
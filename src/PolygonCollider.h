@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Components.hpp"
+
+#include <cstddef>
+
+// Exact overlap between the regular polygons CShape describes, placed the way
+// ShapeBatch draws them (first point up, CTransform::angle in degrees, the
+// outline left out). Shapes with more than MAX_POINTS points, bullets among
+// them, are treated as circles of the shape's radius.
+//
+// It's a separating-axis test. The axes are the edge normals of both
+// polygons, or for a circle the line from its centre to the polygon's
+// nearest corner. Every point count's unit corners and normals are tabled
+// once, and each shape is padded to MAX_POINTS corners and normals by
+// repeating its own, so every test projects the same fixed number of points
+// onto the same fixed number of axes. Those loops have no branches and a
+// known trip count, and the compiler vectorizes them across the axes.
+//
+// The corners and the rotation come from a fixed sine and cosine rather
+// than libm's, so a hit, and the world hash after it, is the same on every
+// machine.
+//
+// Only worth running on pairs that already overlap as circles; a pair of
+// circles is reported as overlapping without looking.
+class PolygonCollider
+{
+  public:
+    static constexpr size_t MAX_POINTS = 8;
+
+    static bool isPolygon(const CShape &shape)
+    {
+        return shape.points >= 3 && shape.points <= MAX_POINTS;
+    }
+
+    static bool overlaps(const CShape &sa, const CTransform &ta, const CShape &sb, const CTransform &tb);
+};
@@ -0,0 +1,288 @@
+#pragma once
+
+// Frame profiler. PROFILE_SCOPE("name") times the enclosing block and files
+// it under the current frame; PROFILE_FRAME_BEGIN/END bracket a frame.
+// Finished frames live in a fixed ring owned by the thread that records
+// them. Only that thread may read them back: nothing stops it overwriting
+// the oldest slot while another thread is reading it.
+//
+// Each zone also records the heap allocations made inside it (children
+// included), counted by AllocTracker.
+//
+// While a TraceRecorder capture is running, zones and frames are also
+// written to the trace.
+//
+// Everything here is only compiled with -DARCHANGEL_PROFILE (make PROFILE=1,
+// the default). Without it the macros expand to nothing and no profiler code
+// or data ends up in the binary.
+
+#ifdef ARCHANGEL_PROFILE
+
+#include "AllocTracker.h"
+#include "Trace.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+struct ZoneSample
+{
+    std::uint16_t zone = 0;
+    std::uint16_t depth = 0;
+    std::uint32_t allocs = 0;
+    std::uint64_t startNs = 0;
+    std::uint64_t durationNs = 0;
+    std::uint64_t allocBytes = 0;
+};
+
+struct FrameRecord
+{
+    static constexpr size_t MAX_ZONES = 96;
+
+    std::uint64_t frame = 0;
+    std::uint64_t startNs = 0;
+    std::uint64_t durationNs = 0;
+    std::uint32_t count = 0;
+    std::array<ZoneSample, MAX_ZONES> zones;
+};
+
+struct ZoneStats
+{
+    float minMs = 0.f;
+    float avgMs = 0.f;
+    float p99Ms = 0.f;
+    float lastMs = 0.f;
+    float allocs = 0.f;
+    float allocBytes = 0.f;
+};
+
+class Profiler
+{
+  public:
+    static constexpr size_t FRAMES = 256;
+    static constexpr size_t MAX_ZONE_NAMES = 128;
+
+  private:
+    // zone names are shared by every thread so a call site's id is the same
+    // whichever thread registered it
+    static inline std::array<std::atomic<const char *>, MAX_ZONE_NAMES> s_names{};
+    static inline std::atomic<size_t> s_nameCount{0};
+    static inline std::mutex s_nameMutex;
+
+    std::vector<FrameRecord> m_frames = std::vector<FrameRecord>(FRAMES);
+    std::atomic<std::uint64_t> m_published{0};
+    std::uint16_t m_depth = 0;
+
+    FrameRecord &current()
+    {
+        return m_frames[m_published.load(std::memory_order_relaxed) % FRAMES];
+    }
+
+  public:
+    // One profiler per thread; the game thread's is the one the UI shows.
+    static Profiler &instance()
+    {
+        thread_local Profiler profiler;
+        return profiler;
+    }
+
+    static std::uint64_t now()
+    {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    static std::uint16_t zoneId(const char *name)
+    {
+        size_t count = s_nameCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (s_names[i].load(std::memory_order_relaxed) == name) return static_cast<std::uint16_t>(i);
+        }
+
+        std::lock_guard<std::mutex> lock(s_nameMutex);
+        count = s_nameCount.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (std::strcmp(s_names[i].load(std::memory_order_relaxed), name) == 0) return static_cast<std::uint16_t>(i);
+        }
+        if (count == MAX_ZONE_NAMES)
+        {
+            return static_cast<std::uint16_t>(count - 1);
+        }
+        s_names[count].store(name, std::memory_order_relaxed);
+        s_nameCount.store(count + 1, std::memory_order_release);
+        return static_cast<std::uint16_t>(count);
+    }
+
+    static const char *zoneName(std::uint16_t zone)
+    {
+        return s_names[zone].load(std::memory_order_relaxed);
+    }
+
+    static size_t zoneCount()
+    {
+        return s_nameCount.load(std::memory_order_acquire);
+    }
+
+    void beginFrame()
+    {
+        auto &f = current();
+        f.frame = m_published.load(std::memory_order_relaxed);
+        f.startNs = now();
+        f.count = 0;
+        m_depth = 0;
+    }
+
+    void endFrame()
+    {
+        auto &f = current();
+        std::uint64_t end = now();
+        f.durationNs = end - f.startNs;
+        if (TraceRecorder::recording())
+        {
+            TraceRecorder::instance().complete("frame", f.startNs, end);
+        }
+        m_published.fetch_add(1, std::memory_order_release);
+    }
+
+    std::uint16_t pushDepth()
+    {
+        return m_depth++;
+    }
+
+    void record(std::uint16_t zone, std::uint16_t depth, std::uint64_t start, std::uint64_t end,
+                std::uint64_t allocs, std::uint64_t allocBytes)
+    {
+        m_depth = depth;
+        auto &f = current();
+        if (f.count < FrameRecord::MAX_ZONES)
+        {
+            f.zones[f.count++] = {zone, depth, static_cast<std::uint32_t>(allocs), start, end - start, allocBytes};
+        }
+    }
+
+    // Completed frames available to the recording thread. The slot being
+    // written is never handed out.
+    size_t frameCount() const
+    {
+        return static_cast<size_t>(std::min<std::uint64_t>(m_published.load(std::memory_order_acquire), FRAMES - 1));
+    }
+
+    // ago = 0 is the most recently completed frame.
+    const FrameRecord &frame(size_t ago) const
+    {
+        std::uint64_t published = m_published.load(std::memory_order_acquire);
+        return m_frames[(published - 1 - ago) % FRAMES];
+    }
+
+    // Total time spent in zone in each of the last frames, oldest first.
+    void zoneTimes(std::uint16_t zone, size_t frames, std::vector<float> &outMs) const
+    {
+        outMs.clear();
+        frames = std::min(frames, frameCount());
+        for (size_t ago = frames; ago-- > 0;)
+        {
+            const auto &f = frame(ago);
+            std::uint64_t ns = 0;
+            for (std::uint32_t i = 0; i < f.count; i++)
+            {
+                if (f.zones[i].zone == zone) ns += f.zones[i].durationNs;
+            }
+            outMs.push_back(static_cast<float>(ns) * 1e-6f);
+        }
+    }
+
+    ZoneStats stats(std::uint16_t zone, size_t frames, std::vector<float> &scratch) const
+    {
+        ZoneStats s;
+        zoneTimes(zone, frames, scratch);
+        if (scratch.empty()) return s;
+
+        s.lastMs = scratch.back();
+        float sum = 0.f;
+        for (float v : scratch) sum += v;
+        s.avgMs = sum / static_cast<float>(scratch.size());
+
+        size_t p99 = std::min(scratch.size() - 1, scratch.size() * 99 / 100);
+        std::nth_element(scratch.begin(), scratch.begin() + p99, scratch.end());
+        s.p99Ms = scratch[p99];
+        s.minMs = *std::min_element(scratch.begin(), scratch.end());
+
+        // average allocations per frame over the same window
+        std::uint64_t allocs = 0;
+        std::uint64_t bytes = 0;
+        for (size_t ago = 0; ago < scratch.size(); ago++)
+        {
+            const auto &f = frame(ago);
+            for (std::uint32_t i = 0; i < f.count; i++)
+            {
+                if (f.zones[i].zone != zone) continue;
+                allocs += f.zones[i].allocs;
+                bytes += f.zones[i].allocBytes;
+            }
+        }
+        s.allocs = static_cast<float>(allocs) / static_cast<float>(scratch.size());
+        s.allocBytes = static_cast<float>(bytes) / static_cast<float>(scratch.size());
+        return s;
+    }
+};
+
+class ProfileScope
+{
+    Profiler &m_profiler;
+    std::uint16_t m_zone;
+    std::uint16_t m_depth;
+    AllocCounters m_allocs;
+    std::uint64_t m_start;
+
+  public:
+    explicit ProfileScope(std::uint16_t zone)
+        : m_profiler(Profiler::instance()), m_zone(zone), m_depth(m_profiler.pushDepth()),
+          m_allocs(AllocTracker::totals()), m_start(Profiler::now()) {}
+
+    explicit ProfileScope(const char *name)
+        : ProfileScope(Profiler::zoneId(name)) {}
+
+    ~ProfileScope()
+    {
+        std::uint64_t end = Profiler::now();
+        const AllocCounters &allocs = AllocTracker::totals();
+        m_profiler.record(m_zone, m_depth, m_start, end, allocs.count - m_allocs.count, allocs.bytes - m_allocs.bytes);
+        if (TraceRecorder::recording())
+        {
+            TraceRecorder::instance().complete(Profiler::zoneName(m_zone), m_start, end);
+        }
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// name must be a string literal; the id is looked up once per call site
+#define PROFILE_SCOPE(name)                                                                     \
+    static const std::uint16_t PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::zoneId(name); \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__))
+
+// for names only known at run time, e.g. World::systemName()
+#define PROFILE_SCOPE_NAMED(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+
+#define PROFILE_FRAME_BEGIN() Profiler::instance().beginFrame()
+#define PROFILE_FRAME_END() Profiler::instance().endFrame()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_SCOPE_NAMED(name)
+#define PROFILE_FRAME_BEGIN()
+#define PROFILE_FRAME_END()
+
+#endif
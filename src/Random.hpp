@@ -0,0 +1,146 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+// xoshiro256++ (Blackman & Vigna): 32 bytes of state, a few adds, shifts and
+// rotates per 64-bit output, and a jump() that skips 2^128 outputs. Streams
+// made with stream(seed, n) start 2^128 apart, so systems that each own one
+// never overlap and never depend on each other's call counts.
+class Rng
+{
+    std::array<std::uint64_t, 4> m_s{};
+
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    static std::uint64_t splitmix64(std::uint64_t &x)
+    {
+        std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+  public:
+    Rng()
+    {
+        seed(0);
+    }
+
+    explicit Rng(std::uint64_t value)
+    {
+        seed(value);
+    }
+
+    // The n-th independent stream of seed.
+    static Rng stream(std::uint64_t seed, unsigned n)
+    {
+        Rng rng(seed);
+        for (unsigned i = 0; i < n; i++)
+        {
+            rng.jump();
+        }
+        return rng;
+    }
+
+    const std::array<std::uint64_t, 4> &state() const
+    {
+        return m_s;
+    }
+
+    void setState(const std::array<std::uint64_t, 4> &state)
+    {
+        m_s = state;
+    }
+
+    void seed(std::uint64_t value)
+    {
+        for (auto &s : m_s)
+        {
+            s = splitmix64(value);
+        }
+    }
+
+    std::uint64_t next()
+    {
+        const std::uint64_t result = rotl(m_s[0] + m_s[3], 23) + m_s[0];
+        const std::uint64_t t = m_s[1] << 17;
+        m_s[2] ^= m_s[0];
+        m_s[3] ^= m_s[1];
+        m_s[1] ^= m_s[2];
+        m_s[0] ^= m_s[3];
+        m_s[2] ^= t;
+        m_s[3] = rotl(m_s[3], 45);
+        return result;
+    }
+
+    // Equivalent to 2^128 calls to next().
+    void jump()
+    {
+        static constexpr std::array<std::uint64_t, 4> JUMP = {
+            0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull};
+
+        std::array<std::uint64_t, 4> s{};
+        for (std::uint64_t word : JUMP)
+        {
+            for (int b = 0; b < 64; b++)
+            {
+                if (word & (1ull << b))
+                {
+                    for (size_t i = 0; i < 4; i++) s[i] ^= m_s[i];
+                }
+                next();
+            }
+        }
+        m_s = s;
+    }
+
+    // [0, 1) from the top 24 bits.
+    float uniform01()
+    {
+        return static_cast<float>(next() >> 40) * 0x1.0p-24f;
+    }
+
+    float uniform(float min, float max)
+    {
+        return min + (max - min) * uniform01();
+    }
+
+    // [min, max] inclusive, by multiply-shift (Lemire) without the rejection
+    // step; the bias is below 2^-32 for any range this game uses.
+    int uniformInt(int min, int max)
+    {
+        auto range = static_cast<std::uint64_t>(static_cast<std::int64_t>(max) - min + 1);
+        return min + static_cast<int>(((next() >> 32) * range) >> 32);
+    }
+
+    // Fills out with uniform floats in [min, max). Each 64-bit output yields
+    // two values, and the scale loop over the span is left for the compiler
+    // to vectorize.
+    void fillUniform(std::span<float> out, float min, float max)
+    {
+        const size_t n = out.size();
+        float *__restrict p = out.data();
+        size_t i = 0;
+        for (; i + 1 < n; i += 2)
+        {
+            std::uint64_t r = next();
+            p[i] = static_cast<float>(r >> 40) * 0x1.0p-24f;
+            p[i + 1] = static_cast<float>((r >> 8) & 0xFFFFFF) * 0x1.0p-24f;
+        }
+        if (i < n)
+        {
+            p[i] = uniform01();
+        }
+
+        const float scale = max - min;
+        for (i = 0; i < n; i++)
+        {
+            p[i] = min + scale * p[i];
+        }
+    }
+};
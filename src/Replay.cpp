@@ -0,0 +1,310 @@
+#include "Replay.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+constexpr char MAGIC[4] = {'A', 'G', 'R', 'P'};
+constexpr char INDEX_MAGIC[4] = {'A', 'G', 'R', 'I'};
+// 2 added Special records; version 1 files still read
+constexpr std::uint32_t VERSION = 2;
+constexpr size_t HEADER_SIZE = 4 + 4 + 8 + 4 + 4;
+constexpr size_t TRAILER_SIZE = 8 + 4 + 4;
+
+enum RecordKind : std::uint8_t
+{
+    RecordInput = 0,
+    RecordShot = 1,
+    RecordKeyframe = 2,
+    RecordEnd = 3,
+    RecordSpecial = 4
+};
+
+struct Record
+{
+    std::uint64_t tick = 0;
+    std::uint8_t kind = 0;
+    std::uint8_t input = 0;
+    Vec2<float> target;
+    const std::uint8_t *data = nullptr;
+    size_t size = 0;
+    std::uint64_t hash = 0;
+};
+
+// Reads the record at in's position; tick is the previous record's tick.
+bool readRecord(ByteReader &in, std::uint64_t tick, Record &r)
+{
+    std::uint64_t delta = 0;
+    std::uint8_t head = 0;
+    if (!in.getVarint(delta) || !in.get(head)) return false;
+
+    r.tick = tick + delta;
+    r.kind = head >> 4;
+    r.input = head & 0x0F;
+    switch (r.kind)
+    {
+        case RecordInput:
+            return true;
+        case RecordShot:
+        case RecordSpecial:
+            return in.get(r.target.x) && in.get(r.target.y);
+        case RecordKeyframe:
+        {
+            std::uint64_t size = 0;
+            if (!in.getVarint(size)) return false;
+            r.size = static_cast<size_t>(size);
+            r.data = in.skip(r.size);
+            return r.data != nullptr;
+        }
+        case RecordEnd:
+            return in.get(r.hash);
+        default:
+            return false;
+    }
+}
+}
+
+ReplayWriter::~ReplayWriter()
+{
+    if (m_file)
+    {
+        std::fclose(m_file);
+    }
+}
+
+void ReplayWriter::flush()
+{
+    if (!m_buffer.empty())
+    {
+        std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file);
+        m_offset += m_buffer.size();
+        m_buffer.clear();
+    }
+}
+
+bool ReplayWriter::open(const std::string &path, const World &world, int fps, int keyframeInterval)
+{
+    if (m_file)
+    {
+        std::fclose(m_file);
+    }
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file)
+    {
+        std::cerr << "Error: Could not open replay file " << path << "\n";
+        return false;
+    }
+
+    m_buffer.clear();
+    m_index.clear();
+    m_offset = 0;
+    m_interval = std::max(keyframeInterval, 1);
+    m_lastTick = static_cast<std::uint64_t>(world.currentFrame());
+
+    ByteWriter out(m_buffer);
+    out.putBytes(MAGIC, sizeof(MAGIC));
+    out.put(VERSION);
+    out.put(world.seed());
+    out.put(static_cast<std::uint32_t>(fps));
+    out.put(static_cast<std::uint32_t>(m_interval));
+    return true;
+}
+
+void ReplayWriter::record(const World &world)
+{
+    if (!m_file) return;
+
+    const auto tick = static_cast<std::uint64_t>(world.currentFrame());
+    ByteWriter out(m_buffer);
+    auto head = [&](std::uint8_t kind, std::uint8_t bits)
+    {
+        out.putVarint(tick - m_lastTick);
+        out.put(static_cast<std::uint8_t>(kind << 4 | (bits & 0x0F)));
+        m_lastTick = tick;
+    };
+
+    // the first tick always gets one, so playback has somewhere to start
+    if (m_index.empty() || tick - m_index.back().first >= static_cast<std::uint64_t>(m_interval))
+    {
+        m_keyframe.clear();
+        ByteWriter state(m_keyframe);
+        world.save(state);
+
+        m_index.emplace_back(tick, m_offset + m_buffer.size());
+        head(RecordKeyframe, 0);
+        out.putVarint(m_keyframe.size());
+        out.putBytes(m_keyframe.data(), m_keyframe.size());
+    }
+
+    for (const auto &a : world.pendingActions())
+    {
+        if (a.kind == World::PlayerAction::Kind::Input)
+        {
+            head(RecordInput, a.input);
+        }
+        else
+        {
+            // a special's input bits are its weapon
+            head(a.kind == World::PlayerAction::Kind::Shot ? RecordShot : RecordSpecial, a.input);
+            out.put(a.target.x);
+            out.put(a.target.y);
+        }
+    }
+
+    if (m_buffer.size() > (1 << 16))
+    {
+        flush();
+    }
+}
+
+bool ReplayWriter::close(const World &world)
+{
+    if (!m_file) return false;
+
+    const auto tick = static_cast<std::uint64_t>(world.currentFrame());
+    ByteWriter out(m_buffer);
+    out.putVarint(tick - m_lastTick);
+    out.put(static_cast<std::uint8_t>(RecordEnd << 4));
+    out.put(world.hash());
+
+    std::uint64_t indexOffset = m_offset + m_buffer.size();
+    for (const auto &[keyTick, offset] : m_index)
+    {
+        out.put(keyTick);
+        out.put(offset);
+    }
+    out.put(indexOffset);
+    out.put(static_cast<std::uint32_t>(m_index.size()));
+    out.putBytes(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+    flush();
+    bool ok = std::ferror(m_file) == 0;
+    ok = std::fclose(m_file) == 0 && ok;
+    m_file = nullptr;
+    return ok;
+}
+
+bool ReplayReader::open(const std::string &path)
+{
+    m_keyframes.clear();
+    if (!m_file.open(path)) return false;
+
+    const std::uint8_t *data = m_file.data();
+    const size_t size = m_file.size();
+    auto fail = [&path](const char *why)
+    {
+        std::cerr << "Error: " << path << ": " << why << "\n";
+        return false;
+    };
+
+    if (size < HEADER_SIZE + TRAILER_SIZE || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0 ||
+        std::memcmp(data + size - sizeof(INDEX_MAGIC), INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+    {
+        return fail("not a replay file");
+    }
+
+    ByteReader header(data, size);
+    header.seek(sizeof(MAGIC));
+    std::uint32_t version = 0;
+    std::uint32_t interval = 0;
+    header.get(version);
+    header.get(m_seed);
+    header.get(m_fps);
+    header.get(interval);
+    if (version < 1 || version > VERSION) return fail("unsupported replay version");
+
+    ByteReader trailer(data, size);
+    trailer.seek(size - TRAILER_SIZE);
+    std::uint64_t indexOffset = 0;
+    std::uint32_t count = 0;
+    trailer.get(indexOffset);
+    trailer.get(count);
+    if (indexOffset > size - TRAILER_SIZE || (size - TRAILER_SIZE - indexOffset) / 16 < count || count == 0)
+    {
+        return fail("corrupt keyframe index");
+    }
+
+    ByteReader index(data, size);
+    index.seek(static_cast<size_t>(indexOffset));
+    m_keyframes.resize(count);
+    for (auto &k : m_keyframes)
+    {
+        index.get(k.tick);
+        index.get(k.offset);
+    }
+
+    // the end record follows the last keyframe's actions
+    ByteReader in(data, static_cast<size_t>(indexOffset));
+    in.seek(static_cast<size_t>(m_keyframes.back().offset));
+    std::uint64_t tick = m_keyframes.back().tick;
+    Record r;
+    while (readRecord(in, tick, r))
+    {
+        tick = r.tick;
+        if (r.kind == RecordEnd)
+        {
+            m_endTick = r.tick;
+            m_finalHash = r.hash;
+            return true;
+        }
+    }
+    return fail("missing end record");
+}
+
+bool ReplayReader::seek(World &world, std::uint64_t tick)
+{
+    auto it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), tick,
+                               [](std::uint64_t t, const Keyframe &k) { return t < k.tick; });
+    if (it == m_keyframes.begin()) return false;
+    --it;
+
+    ByteReader in(m_file.data(), m_file.size());
+    in.seek(static_cast<size_t>(it->offset));
+    Record r;
+    if (!readRecord(in, it->tick, r) || r.kind != RecordKeyframe) return false;
+
+    ByteReader state(r.data, r.size);
+    if (!world.load(state)) return false;
+
+    m_cursor = in.position();
+    m_cursorTick = it->tick;
+
+    const float dt = 1.f / static_cast<float>(m_fps);
+    while (static_cast<std::uint64_t>(world.currentFrame()) < tick && queueActions(world))
+    {
+        world.step(dt);
+    }
+    return static_cast<std::uint64_t>(world.currentFrame()) == tick;
+}
+
+bool ReplayReader::queueActions(World &world)
+{
+    const auto tick = static_cast<std::uint64_t>(world.currentFrame());
+    ByteReader in(m_file.data(), m_file.size());
+    in.seek(m_cursor);
+
+    Record r;
+    for (;;)
+    {
+        size_t at = in.position();
+        if (!readRecord(in, m_cursorTick, r)) return false;
+
+        // leave records for later ticks where they are
+        if (r.tick > tick)
+        {
+            in.seek(at);
+            break;
+        }
+        m_cursorTick = r.tick;
+
+        if (r.kind == RecordEnd) return false;
+        if (r.kind == RecordInput) world.queueInput(r.input);
+        if (r.kind == RecordShot) world.queueShot(r.target);
+        if (r.kind == RecordSpecial) world.queueSpecial(r.target, static_cast<World::SpecialWeapon>(r.input));
+    }
+
+    m_cursor = in.position();
+    return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// Input-log replays. A replay is the world's starting keyframe plus every
+// player action with the tick it was applied on; a deterministic world
+// (see DeterministicConfig) fed the same actions reproduces the session
+// exactly. Further keyframes every few seconds make seeking cheap: restore
+// the nearest one at or before the target and fast-forward.
+//
+// File layout (little-endian):
+//   header   "AGRP", u32 version, u64 seed, u32 fps, u32 keyframe interval
+//   records  varint tick delta, u8 (kind << 4 | input bits), then
+//              Shot:     f32 x, f32 y
+//              Special:  f32 x, f32 y, the weapon as the input bits
+//              Keyframe: varint size, World::save bytes
+//              End:      u64 World::hash at the last tick
+//   index    per keyframe: u64 tick, u64 record offset
+//   trailer  u64 index offset, u32 keyframe count, "AGRI"
+
+#include "MappedFile.h"
+#include "World.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class ReplayWriter
+{
+    std::FILE *m_file = nullptr;
+    std::vector<std::uint8_t> m_buffer;
+    std::vector<std::uint8_t> m_keyframe;
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> m_index;
+    std::uint64_t m_offset = 0;
+    std::uint64_t m_lastTick = 0;
+    int m_interval = 600;
+
+    void flush();
+
+  public:
+    ~ReplayWriter();
+
+    // Starts a replay at the world's current tick.
+    bool open(const std::string &path, const World &world, int fps, int keyframeInterval);
+
+    // Call right before each World::step: writes a keyframe when one is due
+    // and the actions queued for this tick.
+    void record(const World &world);
+
+    // Writes the end record and the keyframe index and closes the file.
+    bool close(const World &world);
+
+    bool isOpen() const
+    {
+        return m_file != nullptr;
+    }
+};
+
+class ReplayReader
+{
+    struct Keyframe
+    {
+        std::uint64_t tick;
+        std::uint64_t offset;
+    };
+
+    MappedFile m_file;
+    std::vector<Keyframe> m_keyframes;
+    std::uint64_t m_seed = 0;
+    std::uint32_t m_fps = 60;
+    std::uint64_t m_endTick = 0;
+    std::uint64_t m_finalHash = 0;
+
+    // playback cursor
+    size_t m_cursor = 0;
+    std::uint64_t m_cursorTick = 0;
+
+  public:
+    // Maps the file and reads its header and index.
+    bool open(const std::string &path);
+
+    // Restores the nearest keyframe at or before tick and steps the world up
+    // to it, so the next step() runs tick.
+    bool seek(World &world, std::uint64_t tick);
+
+    // Queues the actions recorded for the world's current tick. Returns
+    // false once the recording has ended.
+    bool queueActions(World &world);
+
+    std::uint64_t seed() const { return m_seed; }
+    std::uint32_t fps() const { return m_fps; }
+    std::uint64_t startTick() const { return m_keyframes.empty() ? 0 : m_keyframes.front().tick; }
+    std::uint64_t endTick() const { return m_endTick; }
+    std::uint64_t finalHash() const { return m_finalHash; }
+    size_t keyframeCount() const { return m_keyframes.size(); }
+};
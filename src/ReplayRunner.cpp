@@ -0,0 +1,84 @@
+#include "Config.h"
+#include "Profiler.hpp"
+#include "Replay.h"
+#include "World.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Plays a replay headlessly as fast as possible and checks the final world
+// hash against the recording.
+// usage: replay_runner replay.bin [config] [seek tick]
+// With a seek tick, the run first seeks there (reporting how long that took)
+// and plays on to the end from that point.
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: replay_runner replay.bin [config] [seek tick]\n";
+        return 2;
+    }
+    std::string replayPath = argv[1];
+    std::string configPath = argc > 2 ? argv[2] : "res/config.txt";
+
+    GameConfig config;
+    if (!loadConfig(configPath, config))
+    {
+        return 2;
+    }
+
+    ReplayReader replay;
+    if (!replay.open(replayPath))
+    {
+        return 2;
+    }
+    std::uint64_t seekTick = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : replay.startTick();
+
+    config.seed.VALUE = replay.seed();
+    World world;
+    world.init(config);
+
+    auto seekStart = std::chrono::steady_clock::now();
+    if (!replay.seek(world, seekTick))
+    {
+        std::cerr << "Error: Could not seek to tick " << seekTick << " (replay covers " << replay.startTick()
+                  << " to " << replay.endTick() << ")\n";
+        return 2;
+    }
+    std::chrono::duration<double, std::milli> seekMs = std::chrono::steady_clock::now() - seekStart;
+
+    const float dt = 1.f / static_cast<float>(replay.fps());
+    long ticks = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (replay.queueActions(world))
+    {
+        PROFILE_FRAME_BEGIN();
+        world.step(dt, []([[maybe_unused]] World::System system, auto &&fn)
+        {
+            PROFILE_SCOPE_NAMED(World::systemName(system));
+            fn();
+        });
+        PROFILE_FRAME_END();
+        ticks++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    char expected[20];
+    char actual[20];
+    std::snprintf(expected, sizeof(expected), "%016llx", static_cast<unsigned long long>(replay.finalHash()));
+    std::snprintf(actual, sizeof(actual), "%016llx", static_cast<unsigned long long>(world.hash()));
+
+    std::cout << "replay ticks " << replay.startTick() << " to " << replay.endTick() << ", "
+              << replay.keyframeCount() << " keyframes, seek to " << seekTick << " took " << seekMs.count() << " ms\n";
+    std::cout << ticks << " ticks in " << elapsed.count() << " s (" << ticks / elapsed.count() << " ticks/s)\n";
+    if (world.hash() != replay.finalHash())
+    {
+        std::cout << "DIVERGED: final hash " << actual << ", recorded " << expected << "\n";
+        return 1;
+    }
+    std::cout << "final hash " << actual << " matches\n";
+    return 0;
+}
@@ -0,0 +1,198 @@
+#include "Config.h"
+#include "NetClient.h"
+#include "NetServer.h"
+#include "Random.hpp"
+#include "World.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Dedicated server: runs the simulation with no window and streams it to
+// clients over UDP (see NetServer.h). Games connect with a Net section in
+// their config naming this host and port.
+// usage: server [config] [--port n] [--max-clients n] [--enemies n] [--bots n] [--ticks n] [--loss f]
+//               [--unpaced]
+// --max-clients caps how many clients may join besides the bots (default
+// NetServer::DEFAULT_MAX_CLIENTS). --enemies spawns that many enemies up
+// front, for load testing. --bots connects that many in-process clients
+// over loopback, which press random keys and check every snapshot they
+// decode against the one the server captured. --loss drops that fraction
+// of outgoing packets. --unpaced runs ticks back to back instead of at the
+// configured frame rate.
+int main(int argc, char *argv[])
+{
+    std::string configPath = "res/config.txt";
+    long port = -1;
+    long maxClients = static_cast<long>(NetServer::DEFAULT_MAX_CLIENTS);
+    long enemies = 0;
+    long botCount = 0;
+    long ticks = -1;
+    float loss = 0.f;
+    bool unpaced = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--port" && hasValue) port = std::atol(argv[++i]);
+        else if (arg == "--max-clients" && hasValue) maxClients = std::atol(argv[++i]);
+        else if (arg == "--enemies" && hasValue) enemies = std::atol(argv[++i]);
+        else if (arg == "--bots" && hasValue) botCount = std::atol(argv[++i]);
+        else if (arg == "--ticks" && hasValue) ticks = std::atol(argv[++i]);
+        else if (arg == "--loss" && hasValue) loss = std::strtof(argv[++i], nullptr);
+        else if (arg == "--unpaced") unpaced = true;
+        else if (arg.rfind("--", 0) != 0) configPath = arg;
+        else
+        {
+            std::cerr << "usage: server [config] [--port n] [--max-clients n] [--enemies n] [--bots n] [--ticks n] "
+                         "[--loss f] [--unpaced]\n";
+            return 2;
+        }
+    }
+
+    GameConfig config;
+    if (!loadConfig(configPath, config))
+    {
+        return 1;
+    }
+
+    World world;
+    world.init(config);
+    for (long i = 0; i < enemies; i++)
+    {
+        world.spawnEnemy();
+    }
+
+    NetServer server;
+    if (!server.open(static_cast<std::uint16_t>(port >= 0 ? port : config.net.PORT)))
+    {
+        return 1;
+    }
+    server.setPacketLoss(loss);
+    server.setMaxClients(static_cast<size_t>(std::max(0L, maxClients) + std::max(0L, botCount)));
+    std::cout << "listening on port " << server.port() << ", " << config.window.FPS << " ticks/s, snapshots at "
+              << config.net.RATE << "/s\n";
+
+    std::vector<std::unique_ptr<NetClient>> bots;
+    std::vector<std::uint32_t> checkedTick(static_cast<size_t>(botCount), NET_NO_TICK);
+    for (long i = 0; i < botCount; i++)
+    {
+        bots.push_back(std::make_unique<NetClient>());
+        if (!bots.back()->connect("127.0.0.1", server.port()))
+        {
+            return 1;
+        }
+    }
+    Rng botRng(1);
+    long checked = 0;
+    long mismatches = 0;
+
+    const float dt = 1.f / static_cast<float>(config.window.FPS);
+    const long sendEvery = std::max(1, config.window.FPS / config.net.RATE);
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+
+    double simSeconds = 0.0;
+    double netSeconds = 0.0;
+    long reportTicks = 0;
+    std::uint64_t reportBytes = 0;
+    double totalKbPerClient = 0.0;
+    int reports = 0;
+
+    for (long tick = 0; ticks < 0 || tick < ticks; tick++)
+    {
+        const auto tickStart = std::chrono::steady_clock::now();
+        const double now = std::chrono::duration<double>(tickStart - start).count();
+
+        server.receive(world, now);
+        const auto simStart = std::chrono::steady_clock::now();
+        world.step(dt);
+        const auto simEnd = std::chrono::steady_clock::now();
+        if (tick % sendEvery == 0)
+        {
+            server.broadcast(world, dt, now);
+        }
+        const auto netEnd = std::chrono::steady_clock::now();
+        simSeconds += std::chrono::duration<double>(simEnd - simStart).count();
+        netSeconds += std::chrono::duration<double>((simStart - tickStart) + (netEnd - simEnd)).count();
+
+        for (size_t b = 0; b < bots.size(); b++)
+        {
+            NetClient &bot = *bots[b];
+            bot.receive();
+            const NetSnapshot *got = bot.latest();
+            if (got && got->tick != checkedTick[b])
+            {
+                checkedTick[b] = got->tick;
+                const NetSnapshot *sent = server.snapshot(got->tick);
+                if (sent)
+                {
+                    checked++;
+                    if (!(*sent == *got)) mismatches++;
+                }
+            }
+            if (botRng.uniformInt(0, 30) == 0)
+            {
+                bot.setInput(static_cast<std::uint8_t>(botRng.uniformInt(0, 15)));
+            }
+            if (botRng.uniformInt(0, 20) == 0)
+            {
+                bot.queueShot({botRng.uniform(0.f, 1280.f), botRng.uniform(0.f, 720.f)});
+            }
+            bot.sendInput();
+        }
+
+        // report once per simulated second, so unpaced runs read the same
+        if (++reportTicks == config.window.FPS)
+        {
+            const std::uint64_t bytes = server.stats().bytesSent - reportBytes;
+            const size_t clients = server.clientCount();
+            const double kbPerClient = clients ? static_cast<double>(bytes) / 1024.0 / static_cast<double>(clients) : 0.0;
+            std::cout << "tick " << tick + 1 << ": " << world.entities().getEntities().size() << " entities, "
+                      << clients << " clients, sim " << simSeconds * 1000.0 / reportTicks << " ms/tick, net "
+                      << netSeconds * 1000.0 / reportTicks << " ms/tick, " << kbPerClient << " kB/s per client\n";
+            if (clients)
+            {
+                totalKbPerClient += kbPerClient;
+                reports++;
+            }
+            reportBytes = server.stats().bytesSent;
+            simSeconds = 0.0;
+            netSeconds = 0.0;
+            reportTicks = 0;
+        }
+
+        if (!unpaced)
+        {
+            next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(dt));
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    const auto &stats = server.stats();
+    std::cout << stats.fullSnapshots << " full and " << stats.deltaSnapshots << " delta snapshots, "
+              << stats.packetsSent << " packets, " << stats.bytesSent / 1024 << " kB sent";
+    if (reports)
+    {
+        std::cout << ", " << totalKbPerClient / reports << " kB/s per client on average";
+    }
+    std::cout << "\n";
+
+    if (!bots.empty())
+    {
+        std::uint64_t dropped = 0;
+        for (const auto &bot : bots) dropped += bot->snapshotsDropped();
+        std::cout << "bots checked " << checked << " snapshots, " << mismatches << " mismatched, " << dropped
+                  << " dropped\n";
+        if (mismatches)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
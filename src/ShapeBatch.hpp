@@ -0,0 +1,106 @@
+#pragma once
+
+#include "EntityManager.hpp"
+
+#include <SFML/Graphics/Vertex.hpp>
+#include <cmath>
+#include <vector>
+
+// Turns every CShape into triangles in one pass so the whole scene goes out in
+// a single draw call. Geometry matches sf::CircleShape: the first point faces
+// up and a positive outline thickness grows outward from the edge.
+class ShapeBatch
+{
+    static constexpr float PI = 3.14159265f;
+
+    std::vector<sf::Vertex> m_vertices;
+    std::vector<std::vector<Vec2<float>>> m_unitPolygons;
+
+    const std::vector<Vec2<float>> &unitPolygon(size_t points)
+    {
+        if (points >= m_unitPolygons.size())
+        {
+            m_unitPolygons.resize(points + 1);
+        }
+
+        auto &poly = m_unitPolygons[points];
+        if (poly.empty())
+        {
+            for (size_t i = 0; i < points; i++)
+            {
+                float a = static_cast<float>(i) * 2.f * PI / static_cast<float>(points) - PI / 2.f;
+                poly.emplace_back(std::cos(a), std::sin(a));
+            }
+        }
+        return poly;
+    }
+
+    void push(const sf::Vector2f &a, const sf::Vector2f &b, const sf::Vector2f &c, sf::Color col)
+    {
+        m_vertices.push_back({a, col});
+        m_vertices.push_back({b, col});
+        m_vertices.push_back({c, col});
+    }
+
+  public:
+    ShapeBatch() = default;
+
+    void add(const CShape &shape, const CTransform &transform)
+    {
+        const size_t n = shape.points;
+        if (n < 3) return;
+
+        const auto &unit = unitPolygon(n);
+        const float rad = transform.angle * PI / 180.f;
+        const float cs = std::cos(rad);
+        const float sn = std::sin(rad);
+
+        // miter length keeps the outline the same thickness along every edge
+        const float inner = shape.radius;
+        const float outer = shape.radius + shape.thickness / std::cos(PI / static_cast<float>(n));
+        const sf::Vector2f center = transform.pos;
+
+        auto corner = [&](size_t i, float r)
+        {
+            const auto &u = unit[i % n];
+            return center + sf::Vector2f((u.x * cs - u.y * sn) * r, (u.x * sn + u.y * cs) * r);
+        };
+
+        for (size_t i = 0; i < n; i++)
+        {
+            sf::Vector2f in0 = corner(i, inner);
+            sf::Vector2f in1 = corner(i + 1, inner);
+            push(center, in0, in1, shape.fill);
+
+            if (shape.thickness != 0.f)
+            {
+                sf::Vector2f out0 = corner(i, outer);
+                sf::Vector2f out1 = corner(i + 1, outer);
+                push(in0, out0, out1, shape.outline);
+                push(in0, out1, in1, shape.outline);
+            }
+        }
+    }
+
+    void build(const EntityVec &entities)
+    {
+        m_vertices.clear();
+        for (auto &e : entities)
+        {
+            if (e->has<CShape>() && e->has<CTransform>())
+            {
+                add(e->get<CShape>(), e->get<CTransform>());
+            }
+        }
+    }
+
+    const sf::Vertex *data() const
+    {
+        return m_vertices.data();
+    }
+
+    size_t size() const
+    {
+        return m_vertices.size();
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "Vec2.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Uniform grid broadphase over points. build() buckets every item by the cell
+// its position falls in with a counting sort, so the items of a cell are one
+// contiguous run and a rebuild is two linear passes with no per-cell
+// allocation. Positions outside the bounds go to the nearest edge cell.
+class SpatialGrid
+{
+    Vec2<float> m_corner{0.f, 0.f};
+    float m_cell = 64.f;
+    float m_invCell = 1.f / 64.f;
+    int m_width = 0;
+    int m_height = 0;
+    // m_items[m_start[c] .. m_start[c + 1]) are the items in cell c
+    std::vector<std::uint32_t> m_start;
+    std::vector<std::uint32_t> m_items;
+    std::vector<std::uint32_t> m_itemCell;
+    std::vector<std::uint32_t> m_fill;
+
+  public:
+    void build(std::span<const float> xs, std::span<const float> ys, const Vec2<float> &bounds, float cellSize)
+    {
+        build(xs, ys, Vec2<float>(0.f, 0.f), bounds, cellSize);
+    }
+
+    // A grid over the box from corner to corner + bounds.
+    void build(std::span<const float> xs, std::span<const float> ys, const Vec2<float> &corner,
+               const Vec2<float> &bounds, float cellSize)
+    {
+        m_corner = corner;
+        m_cell = std::max(cellSize, 1.f);
+        m_invCell = 1.f / m_cell;
+        m_width = std::max(1, static_cast<int>(std::ceil(bounds.x * m_invCell)));
+        m_height = std::max(1, static_cast<int>(std::ceil(bounds.y * m_invCell)));
+
+        const size_t n = xs.size();
+        const size_t cells = static_cast<size_t>(m_width) * static_cast<size_t>(m_height);
+        m_start.assign(cells + 1, 0);
+        m_itemCell.resize(n);
+        m_items.resize(n);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const auto c = static_cast<std::uint32_t>(cellY(ys[i]) * m_width + cellX(xs[i]));
+            m_itemCell[i] = c;
+            m_start[c + 1]++;
+        }
+        for (size_t c = 0; c < cells; c++)
+        {
+            m_start[c + 1] += m_start[c];
+        }
+
+        // items keep index order within a cell, so queries are deterministic
+        m_fill.assign(m_start.begin(), m_start.end() - 1);
+        for (size_t i = 0; i < n; i++)
+        {
+            m_items[m_fill[m_itemCell[i]]++] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    int cellX(float x) const
+    {
+        return std::clamp(static_cast<int>(std::floor((x - m_corner.x) * m_invCell)), 0, m_width - 1);
+    }
+
+    int cellY(float y) const
+    {
+        return std::clamp(static_cast<int>(std::floor((y - m_corner.y) * m_invCell)), 0, m_height - 1);
+    }
+
+    // Every item, ordered by cell. The cells of a row are adjacent, so the
+    // items in a run of cells along a row are one contiguous stretch.
+    std::span<const std::uint32_t> items() const
+    {
+        return m_items;
+    }
+
+    // Positions in items() of the items in cells x0..x1 of row y, as
+    // [first, last).
+    std::pair<std::uint32_t, std::uint32_t> rowRange(int y, int x0, int x1) const
+    {
+        const size_t row = static_cast<size_t>(y) * static_cast<size_t>(m_width);
+        return {m_start[row + static_cast<size_t>(x0)], m_start[row + static_cast<size_t>(x1) + 1]};
+    }
+
+    std::span<const std::uint32_t> cellItems(int x, int y) const
+    {
+        const size_t c = static_cast<size_t>(y) * static_cast<size_t>(m_width) + static_cast<size_t>(x);
+        return std::span<const std::uint32_t>(m_items).subspan(m_start[c], m_start[c + 1] - m_start[c]);
+    }
+
+    // Calls fn(item) for every item in the cells overlapping the square of
+    // half-size radius around (x, y); a superset of the items within radius.
+    template <typename Fn>
+    void forEachNear(float x, float y, float radius, Fn &&fn) const
+    {
+        const int x0 = cellX(x - radius);
+        const int x1 = cellX(x + radius);
+        const int y0 = cellY(y - radius);
+        const int y1 = cellY(y + radius);
+        for (int cy = y0; cy <= y1; cy++)
+        {
+            for (int cx = x0; cx <= x1; cx++)
+            {
+                for (std::uint32_t item : cellItems(cx, cy))
+                {
+                    fn(item);
+                }
+            }
+        }
+    }
+
+    const Vec2<float> &corner() const
+    {
+        return m_corner;
+    }
+
+    float cellSize() const
+    {
+        return m_cell;
+    }
+
+    int width() const
+    {
+        return m_width;
+    }
+
+    int height() const
+    {
+        return m_height;
+    }
+
+    size_t size() const
+    {
+        return m_items.size();
+    }
+};
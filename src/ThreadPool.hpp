@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads that all run the same job together: run()
+// hands job(worker) to every worker and returns once each has finished. Jobs
+// are expected to split their work by worker index, so the same worker always
+// gets the same share.
+class ThreadPool
+{
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    const std::function<void(size_t)> *m_job = nullptr;
+    std::uint64_t m_generation = 0;
+    size_t m_running = 0;
+    bool m_stop = false;
+
+    void workerLoop(size_t worker)
+    {
+        std::uint64_t seen = 0;
+        for (;;)
+        {
+            const std::function<void(size_t)> *job = nullptr;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+                if (m_stop) return;
+                seen = m_generation;
+                job = m_job;
+            }
+
+            (*job)(worker);
+
+            std::lock_guard lock(m_mutex);
+            if (--m_running == 0) m_finished.notify_one();
+        }
+    }
+
+  public:
+    // 0 threads means one per hardware thread.
+    explicit ThreadPool(size_t threads = 0)
+    {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        m_threads.reserve(threads);
+        for (size_t i = 0; i < threads; i++)
+        {
+            m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto &t : m_threads)
+        {
+            t.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const
+    {
+        return m_threads.size();
+    }
+
+    void run(const std::function<void(size_t)> &job)
+    {
+        std::unique_lock lock(m_mutex);
+        m_job = &job;
+        m_running = m_threads.size();
+        m_generation++;
+        m_wake.notify_all();
+        m_finished.wait(lock, [&] { return m_running == 0; });
+        m_job = nullptr;
+    }
+};
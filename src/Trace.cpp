@@ -0,0 +1,167 @@
+#include "Trace.h"
+
+#ifdef ARCHANGEL_PROFILE
+
+#include "Profiler.hpp"
+
+#include <chrono>
+
+TraceRecorder &TraceRecorder::instance()
+{
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    stop();
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+}
+
+TraceRecorder::ThreadBuffer &TraceRecorder::local()
+{
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (!buffer)
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        m_buffers.push_back(std::make_unique<ThreadBuffer>());
+        buffer = m_buffers.back().get();
+        buffer->tid = static_cast<std::uint32_t>(m_buffers.size());
+    }
+    return *buffer;
+}
+
+void TraceRecorder::push(const TraceEvent &event)
+{
+    auto &buf = local();
+    size_t head = buf.head.load(std::memory_order_relaxed);
+    if (head - buf.tail.load(std::memory_order_acquire) >= ThreadBuffer::CAPACITY)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buf.events[head % ThreadBuffer::CAPACITY] = event;
+    buf.head.store(head + 1, std::memory_order_release);
+}
+
+void TraceRecorder::complete(const char *name, std::uint64_t startNs, std::uint64_t endNs)
+{
+    TraceEvent e;
+    e.name = name;
+    e.startNs = startNs;
+    e.durationNs = endNs - startNs;
+    e.phase = 'X';
+    push(e);
+}
+
+void TraceRecorder::counter(const char *name, const char *series, double value)
+{
+    TraceEvent e;
+    e.name = name;
+    e.series = series;
+    e.startNs = Profiler::now();
+    e.value = value;
+    e.phase = 'C';
+    push(e);
+}
+
+bool TraceRecorder::start(const std::string &path, double seconds)
+{
+    if (writing())
+    {
+        return false;
+    }
+    if (m_writer.joinable())
+    {
+        m_writer.join();
+    }
+
+    m_file = std::fopen(path.c_str(), "w");
+    if (!m_file)
+    {
+        return false;
+    }
+
+    // drop anything left over from the last recording
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        for (auto &buf : m_buffers)
+        {
+            buf->tail.store(buf->head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+    }
+
+    m_path = path;
+    m_written = 0;
+    m_dropped = 0;
+    m_startNs = Profiler::now();
+    m_endNs = m_startNs + static_cast<std::uint64_t>(seconds * 1e9);
+    m_stopRequested = false;
+    m_writing = true;
+    std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", m_file);
+    std::fprintf(m_file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Archangel\"}}");
+
+    s_recording.store(true, std::memory_order_release);
+    m_writer = std::thread(&TraceRecorder::writerLoop, this);
+    return true;
+}
+
+void TraceRecorder::stop()
+{
+    s_recording.store(false, std::memory_order_release);
+    m_stopRequested.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::writerLoop()
+{
+    auto drain = [this]
+    {
+        std::lock_guard<std::mutex> lock(m_buffersMutex);
+        for (auto &buf : m_buffers)
+        {
+            size_t tail = buf->tail.load(std::memory_order_relaxed);
+            size_t head = buf->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++)
+            {
+                const TraceEvent &e = buf->events[tail % ThreadBuffer::CAPACITY];
+                if (e.startNs < m_startNs) continue;
+
+                double ts = static_cast<double>(e.startNs - m_startNs) * 1e-3;
+                if (e.phase == 'X')
+                {
+                    std::fprintf(m_file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                                 e.name, buf->tid, ts, static_cast<double>(e.durationNs) * 1e-3);
+                }
+                else
+                {
+                    std::fprintf(m_file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"%s\":%g}}",
+                                 e.name, buf->tid, ts, e.series, e.value);
+                }
+                m_written.fetch_add(1, std::memory_order_relaxed);
+            }
+            buf->tail.store(head, std::memory_order_release);
+        }
+    };
+
+    while (!m_stopRequested.load(std::memory_order_acquire))
+    {
+        if (Profiler::now() >= m_endNs)
+        {
+            stop();
+            break;
+        }
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    drain();
+    std::fputs("\n]}\n", m_file);
+    std::fclose(m_file);
+    m_file = nullptr;
+    m_writing.store(false, std::memory_order_release);
+}
+
+#endif
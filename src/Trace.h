@@ -0,0 +1,106 @@
+#pragma once
+
+// Chrome Trace Event recorder. While a recording is running every profiler
+// zone is also written out as a complete ("X") event, and callers can add
+// counters. Each thread appends to its own lock-free ring; a background
+// thread drains the rings into a JSON file that chrome://tracing and
+// Perfetto open directly.
+//
+// Like the profiler, this only exists in ARCHANGEL_PROFILE builds.
+
+#ifdef ARCHANGEL_PROFILE
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TraceEvent
+{
+    const char *name = nullptr;
+    const char *series = nullptr;
+    std::uint64_t startNs = 0;
+    std::uint64_t durationNs = 0;
+    double value = 0.0;
+    char phase = 'X';
+};
+
+class TraceRecorder
+{
+    struct ThreadBuffer
+    {
+        static constexpr size_t CAPACITY = 1 << 16;
+
+        std::vector<TraceEvent> events = std::vector<TraceEvent>(CAPACITY);
+        std::atomic<size_t> head{0};
+        std::atomic<size_t> tail{0};
+        std::uint32_t tid = 0;
+    };
+
+    static inline std::atomic<bool> s_recording{false};
+
+    std::mutex m_buffersMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::thread m_writer;
+    std::atomic<bool> m_writing{false};
+    std::atomic<bool> m_stopRequested{false};
+    std::atomic<std::uint64_t> m_written{0};
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::string m_path;
+    std::FILE *m_file = nullptr;
+    std::uint64_t m_startNs = 0;
+    std::uint64_t m_endNs = 0;
+
+    TraceRecorder() = default;
+
+    ThreadBuffer &local();
+    void push(const TraceEvent &event);
+    void writerLoop();
+
+  public:
+    ~TraceRecorder();
+
+    static TraceRecorder &instance();
+
+    // Cheap enough to test on every profiler zone.
+    static bool recording()
+    {
+        return s_recording.load(std::memory_order_relaxed);
+    }
+
+    // Starts writing events to path for at most seconds. Returns false if a
+    // previous recording is still being flushed or the file can't be opened.
+    bool start(const std::string &path, double seconds);
+
+    // Stops recording; the writer finishes the file in the background.
+    void stop();
+
+    void complete(const char *name, std::uint64_t startNs, std::uint64_t endNs);
+    void counter(const char *name, const char *series, double value);
+
+    bool writing() const
+    {
+        return m_writing.load(std::memory_order_acquire);
+    }
+
+    std::uint64_t eventsWritten() const
+    {
+        return m_written.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t eventsDropped() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    const std::string &path() const
+    {
+        return m_path;
+    }
+};
+
+#endif
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <SFML/Graphics.hpp>
-#include <math.h>
+#include <SFML/System/Vector2.hpp>
+#include <cmath>
 #include <iostream>
 
 template <typename T>
@@ -96,12 +96,12 @@ public:
     {
         float dx = rhs.x - x;
         float dy = rhs.y - y;
-        return std::sqrtf(dx * dx + dy * dy);
+        return std::sqrt(dx * dx + dy * dy);
     }
 
     float length() const
     {
-        return std::sqrtf(x * x + y * y);
+        return std::sqrt(x * x + y * y);
     }
 
     void normalize()
@@ -0,0 +1,830 @@
+#include "World.h"
+#include "AllocTracker.h"
+#include "PolygonCollider.h"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+
+namespace
+{
+constexpr int BIG_ENEMY_POINTS = 25;
+constexpr int SMALL_ENEMY_POINTS = 50;
+
+// the layers of the lists special weapons build their query over
+constexpr std::uint32_t ENEMY_LAYER = 1;
+constexpr std::uint32_t SMALL_ENEMY_LAYER = 2;
+
+// The interned tag that entities with it return from tag(), to check a tag
+// by address; nullptr while no entity has had it.
+const std::string *internedTag(const EntityManager &entities, const std::string &tag)
+{
+    auto it = entities.getEntityMap().find(tag);
+    return it != entities.getEntityMap().end() ? &it->first : nullptr;
+}
+}
+
+void World::init(const GameConfig &config)
+{
+    m_playerConfig = config.player;
+    m_enemyConfig = config.enemy;
+    m_bulletConfig = config.bullet;
+    m_chaseConfig = config.chase;
+    m_physicsConfig = config.physics;
+    m_polygonConfig = config.polygons;
+    m_specialConfig = config.special;
+    m_bounds = Vec2<float>(static_cast<float>(config.window.W), static_cast<float>(config.window.H));
+    m_particles.reserve(static_cast<size_t>(config.particles.MAX), config.particles.S);
+    m_bulletPool = m_entities.reserve("bullet", static_cast<size_t>(std::max(config.pool.BULLETS, 0)));
+    m_smallEnemyPool = m_entities.reserve("smallEnemy", static_cast<size_t>(std::max(config.pool.SMALL_ENEMIES, 0)));
+    m_flow.resize(m_bounds, m_chaseConfig.CELL);
+    m_queryFrame = -1;
+
+    m_seed = config.seed.VALUE;
+    if (m_seed == 0)
+    {
+        std::random_device rd;
+        m_seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+    }
+    m_spawnRng = Rng::stream(m_seed, 0);
+    m_splitRng = Rng::stream(m_seed, 1);
+    m_particles.seed(Rng::stream(m_seed, 2));
+
+    spawnPlayer();
+
+    // flush the add queue so player() is valid before the first step
+    m_entities.update();
+}
+
+const char *World::systemName(System system)
+{
+    switch (system)
+    {
+    case System::Update: return "update";
+    case System::Spawner: return "spawner";
+    case System::Movement: return "movement";
+    case System::Lifespan: return "lifespan";
+    case System::Collision: return "collision";
+    case System::Particles: return "particles";
+    default: return "unknown";
+    }
+}
+
+const char *World::specialWeaponName(SpecialWeapon weapon)
+{
+    switch (weapon)
+    {
+    case SpecialWeapon::Laser: return "laser";
+    case SpecialWeapon::Shockwave: return "shockwave";
+    default: return "unknown";
+    }
+}
+
+Entity *World::player()
+{
+    return m_entities.getEntities("player").back();
+}
+
+void World::queueInput(std::uint8_t input)
+{
+    m_actions.push_back({PlayerAction::Kind::Input, input, {}});
+}
+
+void World::queueShot(const Vec2<float> &target)
+{
+    m_actions.push_back({PlayerAction::Kind::Shot, 0, target});
+}
+
+void World::queueSpecial(const Vec2<float> &target, SpecialWeapon weapon)
+{
+    m_actions.push_back({PlayerAction::Kind::Special, static_cast<std::uint8_t>(weapon), target});
+}
+
+void World::applyActions()
+{
+    for (const auto &a : m_actions)
+    {
+        if (a.kind == PlayerAction::Kind::Input)
+        {
+            auto &input = player()->get<CInput>();
+            input.up = a.input & INPUT_UP;
+            input.down = a.input & INPUT_DOWN;
+            input.left = a.input & INPUT_LEFT;
+            input.right = a.input & INPUT_RIGHT;
+        }
+        else if (a.kind == PlayerAction::Kind::Shot)
+        {
+            spawnBullet(player(), a.target);
+        }
+        else
+        {
+            spawnSpecialWeapon(player(), a.target, static_cast<SpecialWeapon>(a.input));
+        }
+    }
+    m_actions.clear();
+}
+
+void World::save(ByteWriter &out) const
+{
+    out.put(static_cast<std::int32_t>(m_score));
+    out.put(static_cast<std::int32_t>(m_currentFrame));
+    out.put(static_cast<std::int32_t>(m_lastEnemySpawnTime));
+    out.put(m_seed);
+    out.put(m_spawnRng.state());
+    out.put(m_splitRng.state());
+    m_entities.save(out);
+    m_particles.save(out);
+}
+
+bool World::load(ByteReader &in)
+{
+    std::int32_t score = 0;
+    std::int32_t frame = 0;
+    std::int32_t lastSpawn = 0;
+    std::array<std::uint64_t, 4> spawnState;
+    std::array<std::uint64_t, 4> splitState;
+    if (!in.get(score) || !in.get(frame) || !in.get(lastSpawn) || !in.get(m_seed) || !in.get(spawnState) ||
+        !in.get(splitState))
+    {
+        return false;
+    }
+
+    m_score = score;
+    m_currentFrame = frame;
+    m_lastEnemySpawnTime = lastSpawn;
+    m_spawnRng.setState(spawnState);
+    m_splitRng.setState(splitState);
+    m_actions.clear();
+    m_queryFrame = -1;
+    return m_entities.load(in) && m_particles.load(in) && !m_entities.getEntities("player").empty();
+}
+
+void World::capture(Snapshot &s) const
+{
+    m_entities.capture(s.entities);
+    m_particles.capture(s.particles);
+    s.actions = m_actions;
+    s.spawnRng = m_spawnRng;
+    s.splitRng = m_splitRng;
+    s.score = m_score;
+    s.currentFrame = m_currentFrame;
+    s.lastEnemySpawnTime = m_lastEnemySpawnTime;
+}
+
+void World::restore(const Snapshot &s)
+{
+    m_entities.restore(s.entities);
+    m_particles.restore(s.particles);
+    m_actions = s.actions;
+    m_spawnRng = s.spawnRng;
+    m_splitRng = s.splitRng;
+    m_score = s.score;
+    m_currentFrame = s.currentFrame;
+    m_lastEnemySpawnTime = s.lastEnemySpawnTime;
+    m_queryFrame = -1;
+}
+
+void World::spawnPlayer()
+{
+    auto size = m_bounds;
+    float spawnX = size.x * 0.5;
+    float spawnY = size.y * 0.5;
+    float angVel = 180.f;
+
+    auto e = m_entities.addEntity("player");
+    e->add<CTransform>(Vec2<float>(spawnX, spawnY), Vec2<float>(0.f, 0.f), 0.0f, angVel);
+    e->add<CShape>(m_playerConfig.SR, m_playerConfig.V,
+                   sf::Color(m_playerConfig.FR, m_playerConfig.FG, m_playerConfig.FB),
+                   sf::Color(m_playerConfig.OR, m_playerConfig.OG, m_playerConfig.OB),
+                   m_playerConfig.OT);
+    e->add<CCollision>(m_playerConfig.CR);
+    e->add<CInput>();
+    e->add<CScore>();
+}
+
+void World::spawnEnemy() 
+{
+    auto &rng = m_spawnRng;
+    int rand_pts = rng.uniformInt(m_enemyConfig.VMIN, m_enemyConfig.VMAX);
+
+    auto size = m_bounds;
+    float x = rng.uniform(m_enemyConfig.SR, size.x - m_enemyConfig.SR);
+    float y = rng.uniform(m_enemyConfig.SR, size.y - m_enemyConfig.SR);
+    Vec2<float> pos(x, y);
+
+    float vx = rng.uniform(m_enemyConfig.SMIN, m_enemyConfig.SMAX);
+    float vy = rng.uniform(m_enemyConfig.SMIN, m_enemyConfig.SMAX);
+    Vec2<float> velocity(vx, vy);
+
+    float angVel = rng.uniform(-180.f, 180.f);
+    if (std::abs(angVel) < 30.f)
+        angVel = (angVel < 0 ? -30.f : 30.f);
+
+    sf::Color randomFill(static_cast<std::uint8_t>(rng.uniformInt(1, 255)),
+                         static_cast<std::uint8_t>(rng.uniformInt(1, 255)),
+                         static_cast<std::uint8_t>(rng.uniformInt(1, 255)));
+
+    auto e = m_entities.addEntity("enemy");
+    e->add<CTransform>(pos, velocity, 0.0f, angVel);
+    e->add<CShape>(m_enemyConfig.SR, rand_pts, randomFill,
+                   sf::Color(m_enemyConfig.OR, m_enemyConfig.OG, m_enemyConfig.OB),
+                   m_enemyConfig.OT);
+    e->add<CCollision>(m_enemyConfig.CR);
+
+    m_lastEnemySpawnTime = m_currentFrame;
+}
+
+void World::spawnSmallEnemies(Entity *e)
+{
+    Vec2<float> spawnLocation = e->get<CTransform>().pos;
+    float angVel = m_splitRng.uniform(-180.f, 180.f);
+    if (std::abs(angVel) < 30.f)
+        angVel = (angVel < 0 ? -30.f : 30.f);
+
+    auto parentFillCol = e->get<CShape>().fill;
+    auto parentOutlineCol = e->get<CShape>().outline;
+    // spawn a number of small enemies equal to the vertices of the original
+    int parentPointCount = static_cast<int>(e->get<CShape>().points);
+
+    // velocity components are drawn for up to 32 children at a time
+    std::array<float, 64> speeds;
+    for (int i = 0; i < parentPointCount; i++)
+    {
+        size_t k = (static_cast<size_t>(i) * 2) % speeds.size();
+        if (k == 0)
+        {
+            size_t left = static_cast<size_t>(parentPointCount - i) * 2;
+            m_splitRng.fillUniform(std::span(speeds.data(), std::min(speeds.size(), left)),
+                                   m_enemyConfig.SMIN, m_enemyConfig.SMAX);
+        }
+        Vec2<float> velocity(speeds[k], speeds[k + 1]);
+        
+        auto s = m_entities.addPooled(m_smallEnemyPool);
+        s->add<CTransform>(spawnLocation, velocity, 0.0f, angVel);
+        s->add<CShape>(m_enemyConfig.SR / 2, parentPointCount,
+             parentFillCol,
+             parentOutlineCol,
+             m_enemyConfig.OT);
+        s->add<CCollision>(m_enemyConfig.CR / 2);
+        s->add<CLifespan>(m_enemyConfig.L);
+    }
+}
+
+void World::spawnBullet(Entity *entity, const Vec2<float> &target)
+{
+    Vec2<float> dir = target - entity->get<CTransform>().pos;
+    dir.normalize();
+    float speed = m_bulletConfig.S;
+    Vec2<float> velocity = dir * speed;
+
+    auto spawnPos = entity->get<CTransform>().pos;
+
+    auto b = m_entities.addPooled(m_bulletPool);
+    b->add<CTransform>(spawnPos, velocity, 0.0f, 0.0f);
+    b->add<CShape>(m_bulletConfig.SR, m_bulletConfig.V,
+                sf::Color(m_bulletConfig.FR, m_bulletConfig.FG, m_bulletConfig.FB),
+                sf::Color(m_bulletConfig.OR, m_bulletConfig.OG, m_bulletConfig.OB),
+                m_bulletConfig.OT);
+    b->add<CCollision>(m_bulletConfig.CR);
+    b->add<CLifespan>(m_bulletConfig.L);
+}
+
+void World::spawnSpecialWeapon(Entity *entity, const Vec2<float> &target, SpecialWeapon weapon)
+{
+    switch (weapon)
+    {
+    case SpecialWeapon::Laser: fireLaser(entity, target); break;
+    case SpecialWeapon::Shockwave: fireShockwave(entity); break;
+    default: break;
+    }
+}
+
+// The live enemies, for the special weapons' queries. sCollision gathers
+// them as it makes their last move of the tick, so specials fired before
+// the next step start from that; the lists are walked here instead when
+// collisions are off or after a load or restore. Every special fired
+// between two steps shares one index until one of them moves an enemy
+// itself. Enemies an earlier special destroyed are still in it.
+CollisionQuery &World::enemyQuery()
+{
+    if (m_queryFrame != m_currentFrame)
+    {
+        m_query.build({&m_entities.getEntities("enemy"), &m_entities.getEntities("smallEnemy")}, m_bounds);
+        m_queryFrame = m_currentFrame;
+    }
+    return m_query;
+}
+
+// A laser from the entity through target to the edge of the screen. It
+// pierces, destroying every enemy along it, and scores as bullets do.
+void World::fireLaser(Entity *entity, const Vec2<float> &target)
+{
+    constexpr float LASER_RADIUS = 4.f;
+
+    const Vec2<float> origin = entity->get<CTransform>().pos;
+    Vec2<float> dir = target - origin;
+    if (dir.x == 0.f && dir.y == 0.f) return;
+    dir.normalize();
+
+    const float toX = dir.x > 0.f ? (m_bounds.x - origin.x) / dir.x : dir.x < 0.f ? -origin.x / dir.x : INFINITY;
+    const float toY = dir.y > 0.f ? (m_bounds.y - origin.y) / dir.y : dir.y < 0.f ? -origin.y / dir.y : INFINITY;
+    const Ray ray{origin, dir, std::max(std::min(toX, toY), 0.f), LASER_RADIUS};
+
+    enemyQuery().raycast(ray, m_rayHits);
+
+    int &score = entity->get<CScore>().score;
+    for (const RayHit &hit : m_rayHits)
+    {
+        Entity *e = hit.entity;
+        if (!e->isAlive()) continue;
+        e->destroy();
+        if (e->tag() == "enemy")
+        {
+            spawnSmallEnemies(e);
+            emitExplosion(e, 240);
+            score += BIG_ENEMY_POINTS;
+        }
+        else
+        {
+            emitExplosion(e, 80);
+            score += SMALL_ENEMY_POINTS;
+        }
+    }
+
+    // the beam, as short-lived sparks along it
+    ParticleBurst spark;
+    spark.speedMin = 10.f;
+    spark.speedMax = 40.f;
+    spark.lifeMin = 0.15f;
+    spark.lifeMax = 0.35f;
+    spark.color = sf::Color(120, 220, 255);
+    for (float t = 0.f; t < ray.length; t += 12.f)
+    {
+        spark.pos = origin + dir * t;
+        m_particles.emit(spark, 2);
+    }
+}
+
+// A shockwave around the entity. Enemies centred within KILL of it are
+// destroyed and score as if shot; the rest touching RADIUS are thrown
+// outward, up to PUSH pixels for those closest in, and turned to head away
+// at the speed they had.
+void World::fireShockwave(Entity *entity)
+{
+    const Vec2<float> origin = entity->get<CTransform>().pos;
+    const float radius = m_specialConfig.RADIUS;
+
+    CollisionQuery &query = enemyQuery();
+    m_areaHits.resize(query.size());
+    const size_t count = query.queryCircle(origin, radius, ENEMY_LAYER | SMALL_ENEMY_LAYER, m_areaHits);
+
+    // A push only moves the enemy pushed, so pushes go in the query's order
+    // and the hits to kill are kept aside. Kills spawn and emit, so they go
+    // in id order to make the same entities and particles on every run.
+    int &score = entity->get<CScore>().score;
+    bool pushed = false;
+    size_t kills = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        Entity *e = m_areaHits[i];
+        if (!e->isAlive()) continue;
+        auto &t = e->get<CTransform>();
+        Vec2<float> away = t.pos - origin;
+        const float d = away.length();
+        if (d <= m_specialConfig.KILL)
+        {
+            m_areaHits[kills++] = e;
+            continue;
+        }
+
+        away = away / d;
+        const float r = e->get<CCollision>().radius;
+        const float push = m_specialConfig.PUSH * std::max(1.f - d / radius, 0.f);
+        t.pos += away * push;
+        t.pos.x = std::clamp(t.pos.x, r, std::max(m_bounds.x - r, r));
+        t.pos.y = std::clamp(t.pos.y, r, std::max(m_bounds.y - r, r));
+        t.velocity = away * t.velocity.length();
+        pushed = true;
+    }
+
+    std::sort(m_areaHits.begin(), m_areaHits.begin() + static_cast<std::ptrdiff_t>(kills),
+              [](const Entity *a, const Entity *b) { return a->id() < b->id(); });
+    for (size_t i = 0; i < kills; i++)
+    {
+        Entity *e = m_areaHits[i];
+        e->destroy();
+        if (e->tag() == "enemy")
+        {
+            spawnSmallEnemies(e);
+            emitExplosion(e, 240);
+            score += BIG_ENEMY_POINTS;
+        }
+        else
+        {
+            emitExplosion(e, 80);
+            score += SMALL_ENEMY_POINTS;
+        }
+    }
+    if (pushed) m_queryFrame = -1;
+
+    // the wave, as a ring of sparks reaching RADIUS as they die
+    ParticleBurst ring;
+    ring.pos = origin;
+    ring.lifeMin = 0.4f;
+    ring.lifeMax = 0.4f;
+    ring.speedMin = radius / ring.lifeMax;
+    ring.speedMax = ring.speedMin;
+    ring.color = sf::Color(255, 200, 120);
+    m_particles.emit(ring, static_cast<size_t>(radius / 4.f));
+}
+
+void World::sMovement(float dt)
+{
+    NO_ALLOC_SCOPE("movement");
+    auto &pTransform = player()->get<CTransform>();
+    auto &pInput = player()->get<CInput>();
+
+    Vec2<float> dir(0.0f, 0.0f);
+
+    if (pInput.up) dir.y -= 1.f;
+    if (pInput.down) dir.y += 1.f;
+    if (pInput.right) dir.x += 1.f;
+    if (pInput.left) dir.x -= 1.f;
+
+    if (dir.x != 0.f || dir.y != 0.f)
+    {
+        dir.normalize();
+        pTransform.velocity = dir * m_playerConfig.S;
+    }
+    else 
+    {
+        pTransform.velocity = {0.f, 0.f};
+    }
+
+    if (m_chaseConfig.ENEMY || m_chaseConfig.SMALL)
+    {
+        m_flow.update(pTransform.pos);
+        steerChasers(dt);
+    }
+    
+    for (auto &e : m_entities.getEntities())
+    {
+        if (!e->has<CTransform>()) continue;
+        auto &t = e->get<CTransform>();
+        t.pos += t.velocity * dt;
+        t.angle += t.angVel * dt;
+    }
+}
+
+// Turns each chaser's velocity toward the flow field's heading, keeping its
+// speed, so enemies home in on the player at the speed they spawned with.
+void World::steerChasers(float dt)
+{
+    PROFILE_SCOPE("movement/chase");
+    const float blend = std::min(1.f, m_chaseConfig.STEER * dt);
+    auto steer = [&](const EntityVec &list)
+    {
+        for (auto e : list)
+        {
+            if (!e->has<CTransform>()) continue;
+
+            auto &t = e->get<CTransform>();
+            const float speed = t.velocity.length();
+            Vec2<float> v = t.velocity + (m_flow.heading(t.pos) * speed - t.velocity) * blend;
+            const float length = v.length();
+            if (length > 0.f)
+            {
+                t.velocity = v * (speed / length);
+            }
+        }
+    };
+
+    if (m_chaseConfig.ENEMY) steer(m_entities.getEntities("enemy"));
+    if (m_chaseConfig.SMALL) steer(m_entities.getEntities("smallEnemy"));
+}
+
+void World::sLifespan()
+{
+    NO_ALLOC_SCOPE("lifespan");
+    for (auto &e : m_entities.getEntities())
+    {
+        if (!e->has<CLifespan>()) continue;
+        
+        auto &life = e->get<CLifespan>();
+  
+        if (life.remaining > 0)
+        {
+            life.remaining -= 1;
+        }
+
+        // Fade alpha 1:1 with remaining lifespan.
+        if (e->has<CShape>())
+        {
+            auto &shape = e->get<CShape>();
+            const float ratio = std::clamp(life.remaining / static_cast<float>(life.lifespan), 0.f, 1.f);
+            auto applyAlpha = [ratio](sf::Color c)
+            {
+                c.a = static_cast<std::uint8_t>(ratio * 255.0f);
+                return c;
+            };
+            shape.fill = applyAlpha(shape.fill);
+            shape.outline = applyAlpha(shape.outline);
+        }
+
+        if (life.remaining <= 0)
+        {
+            e->destroy();
+        }
+    }
+}
+
+void World::sCollision()
+{
+    int &pScore = player()->get<CScore>().score;
+    auto size = m_bounds;
+    
+    {
+        PROFILE_SCOPE("collision/bullets");
+        for (auto b : m_entities.getEntities("bullet"))
+        { 
+            for (auto e : m_entities.getEntities("enemy"))
+            {
+               if (!b->has<CCollision>() || !e->has<CCollision>()) continue;
+
+               if (isColliding(b, e))
+               {
+                    b->destroy();
+                    e->destroy();
+                    spawnSmallEnemies(e);
+                    emitExplosion(e, 240);
+                    pScore += BIG_ENEMY_POINTS;
+               }
+            }
+
+            for (auto e : m_entities.getEntities("smallEnemy"))
+            {
+               if (!b->has<CCollision>() || !e->has<CCollision>()) continue;
+           
+               if (isColliding(b, e))
+               {
+                    b->destroy();
+                    e->destroy();
+                    emitExplosion(e, 80);
+                    pScore += SMALL_ENEMY_POINTS;
+               }
+            }
+        }
+    }
+
+    // Player collisions
+    {
+        PROFILE_SCOPE("collision/player");
+        for (auto e :m_entities.getEntities("enemy"))
+        {
+            if (!e->has<CCollision>()) continue;
+
+            if (isColliding(player(), e))
+            {
+                respawnPlayer(player());
+            }
+        }
+
+        for (auto e :m_entities.getEntities("smallEnemy"))
+        {
+            if (!e->has<CCollision>()) continue;
+
+            if (isColliding(player(), e))
+            {
+                respawnPlayer(player());
+            }
+        }
+    }
+
+    // Enemies against each other
+    if (m_physicsConfig.ENABLED)
+    {
+        PROFILE_SCOPE("collision/contacts");
+        m_contacts.solve({&m_entities.getEntities("enemy"), &m_entities.getEntities("smallEnemy")}, m_physicsConfig,
+                         m_bounds, m_pool);
+    }
+
+    // Collisions with walls. This is the last move enemies make in a tick,
+    // so the special weapons' query is gathered here while each one is at
+    // hand; see enemyQuery().
+    const std::string *enemyTag = internedTag(m_entities, "enemy");
+    const std::string *smallEnemyTag = internedTag(m_entities, "smallEnemy");
+    m_query.clear(m_bounds, m_entities.getEntities().size());
+    m_queryFrame = m_currentFrame + 1;
+    {
+        PROFILE_SCOPE("collision/walls");
+        NO_ALLOC_SCOPE("collision/walls");
+        float w = static_cast<float>(size.x);
+        float h = static_cast<float>(size.y);
+
+        for (auto e : m_entities.getEntities())
+        {
+            if (!e->has<CCollision>() || !e->has<CTransform>()) continue;
+
+            auto &t = e->get<CTransform>();
+            auto &c = e->get<CCollision>();
+            float r = c.radius;
+
+            bool bouncedX = false;
+            bool bouncedY = false;
+
+            // Left wall
+            if (t.pos.x - r < 0.f)
+            {
+                t.pos.x = r;
+                bouncedX = true;
+            }
+            else if (t.pos.x + r > w)
+            {
+                t.pos.x = w - r;
+                bouncedX = true;
+            }
+
+            // Top wall
+            if (t.pos.y - r < 0.f)
+            {
+                t.pos.y = r;
+                bouncedY = true;
+            }
+            else if (t.pos.y + r > h)
+            {
+                t.pos.y = h - r;
+                bouncedY = true;
+            }
+
+            if (bouncedX) { t.velocity.x *= -1.f; }
+            if (bouncedY) { t.velocity.y *= -1.f; }
+
+            if (!e->isAlive()) continue;
+            if (&e->tag() == enemyTag) m_query.add(e, t.pos, r, ENEMY_LAYER);
+            else if (&e->tag() == smallEnemyTag) m_query.add(e, t.pos, r, SMALL_ENEMY_LAYER);
+        }
+    }
+}
+
+void World::sParticles(float dt)
+{
+    NO_ALLOC_SCOPE("particles");
+    {
+        PROFILE_SCOPE("particles/trails");
+        // bullet trails: a few slow sparks drifting behind each bullet
+        for (auto &b : m_entities.getEntities("bullet"))
+        {
+            if (!b->has<CTransform>() || !b->has<CShape>()) continue;
+
+            auto &t = b->get<CTransform>();
+            ParticleBurst trail;
+            trail.pos = t.pos;
+            trail.baseVel = t.velocity * -0.1f;
+            trail.speedMin = 5.f;
+            trail.speedMax = 30.f;
+            trail.lifeMin = 0.15f;
+            trail.lifeMax = 0.35f;
+            trail.color = b->get<CShape>().fill;
+            m_particles.emit(trail, 3);
+        }
+    }
+
+    {
+        PROFILE_SCOPE("particles/update");
+        m_particles.update(dt);
+    }
+}
+
+void World::sEnemySpawner()
+{
+    bool spawnNow = m_currentFrame % m_enemyConfig.SI == 0;
+
+    if (spawnNow)
+    {
+        spawnEnemy();
+    }
+}
+
+namespace
+{
+struct Hasher
+{
+    std::uint64_t h = 0xCBF29CE484222325ull;
+
+    void add(std::uint64_t v)
+    {
+        h = (h ^ v) * 0x100000001B3ull;
+        h ^= h >> 29;
+    }
+
+    void add(float v)
+    {
+        add(static_cast<std::uint64_t>(std::bit_cast<std::uint32_t>(v)));
+    }
+
+    void add(const Vec2<float> &v)
+    {
+        add(v.x);
+        add(v.y);
+    }
+
+    void add(const sf::Color &c)
+    {
+        add(static_cast<std::uint64_t>(c.toInteger()));
+    }
+};
+}
+
+std::uint64_t World::hash() const
+{
+    Hasher hs;
+    hs.add(static_cast<std::uint64_t>(m_currentFrame));
+    hs.add(static_cast<std::uint64_t>(m_lastEnemySpawnTime));
+    hs.add(static_cast<std::uint64_t>(m_particles.size()));
+    for (const Rng *rng : {&m_spawnRng, &m_splitRng})
+    {
+        for (std::uint64_t s : rng->state()) hs.add(s);
+    }
+
+    for (const auto &e : m_entities.getEntities())
+    {
+        hs.add(static_cast<std::uint64_t>(e->id()));
+        hs.add(static_cast<std::uint64_t>(e->isAlive()));
+        if (e->has<CTransform>())
+        {
+            const auto &t = e->get<CTransform>();
+            hs.add(t.pos);
+            hs.add(t.velocity);
+            hs.add(t.angle);
+            hs.add(t.angVel);
+        }
+        if (e->has<CShape>())
+        {
+            const auto &shape = e->get<CShape>();
+            hs.add(shape.radius);
+            hs.add(static_cast<std::uint64_t>(shape.points));
+            hs.add(shape.fill);
+            hs.add(shape.outline);
+        }
+        if (e->has<CCollision>()) hs.add(e->get<CCollision>().radius);
+        if (e->has<CLifespan>()) hs.add(static_cast<std::uint64_t>(e->get<CLifespan>().remaining));
+        if (e->has<CScore>()) hs.add(static_cast<std::uint64_t>(e->get<CScore>().score));
+    }
+    return hs.h;
+}
+
+bool World::isColliding(Entity *a, Entity *b)
+{
+    auto &ta = a->get<CTransform>();
+    auto &tb = b->get<CTransform>();
+
+    auto &ca = a->get<CCollision>();
+    auto &cb = b->get<CCollision>();
+
+    float dx = ta.pos.x - tb.pos.x;
+    float dy = ta.pos.y - tb.pos.y;
+
+    float dist2 = dx * dx + dy * dy;
+    float radiusSum = ca.radius + cb.radius;
+
+    if (dist2 > radiusSum * radiusSum) return false;
+    if (!m_polygonConfig.ENABLED || !a->has<CShape>() || !b->has<CShape>()) return true;
+    return PolygonCollider::overlaps(a->get<CShape>(), ta, b->get<CShape>(), tb);
+}
+
+void World::respawnPlayer(Entity *player)
+{
+    auto size = m_bounds;
+    float spawnX = size.x * 0.5;
+    float spawnY = size.y * 0.5;
+
+    emitExplosion(player, 400);
+    m_playerHit = true;
+
+    auto &transform = player->get<CTransform>();
+    transform.pos = Vec2<float>(spawnX, spawnY);
+    transform.velocity = Vec2<float>(0.f, 0.f);
+}
+
+void World::emitExplosion(Entity *e, size_t count)
+{
+    if (!e->has<CTransform>()) return;
+
+    ParticleBurst burst;
+    burst.pos = e->get<CTransform>().pos;
+    burst.speedMin = 40.f;
+    burst.speedMax = 260.f;
+    burst.lifeMin = 0.3f;
+    burst.lifeMax = 0.9f;
+    if (e->has<CShape>())
+    {
+        burst.color = e->get<CShape>().fill;
+    }
+    m_particles.emit(burst, count);
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include "Bytes.hpp"
+#include "CollisionQuery.h"
+#include "Config.h"
+#include "ContactSolver.h"
+#include "Entity.hpp"
+#include "EntityManager.hpp"
+#include "FlowField.h"
+#include "ParticleSystem.hpp"
+#include "Random.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// The simulation: entity state plus every system that does not need a window.
+// Game drives one of these from its frame loop; the headless runner steps it
+// directly.
+class World
+{
+    friend class WorldFile;
+
+    EntityManager m_entities;
+    // the entity pools bullets and small enemies spawn from
+    size_t m_bulletPool = 0;
+    size_t m_smallEnemyPool = 0;
+    ParticleSystem m_particles;
+    // one random stream per consumer so each system's draws are independent
+    // of how often the others draw
+    std::uint64_t m_seed = 0;
+    Rng m_spawnRng;
+    Rng m_splitRng;
+    PlayerConfig m_playerConfig{};
+    EnemyConfig m_enemyConfig{};
+    BulletConfig m_bulletConfig{};
+    ChaseConfig m_chaseConfig{};
+    // headings toward the player, derived from its position each tick
+    FlowField m_flow;
+    PhysicsConfig m_physicsConfig{};
+    PolygonConfig m_polygonConfig{};
+    SpecialConfig m_specialConfig{};
+    ContactSolver m_contacts;
+    // the live enemies for the special weapons' queries, and the frame they
+    // were gathered in (-1 once out of date); see enemyQuery()
+    CollisionQuery m_query;
+    int m_queryFrame = -1;
+    std::vector<RayHit> m_rayHits;
+    std::vector<Entity *> m_areaHits;
+    ThreadPool *m_pool = nullptr;
+    Vec2<float> m_bounds{1280.f, 720.f};
+    int m_score = 0;
+    int m_currentFrame = 0;
+    int m_lastEnemySpawnTime = 0;
+    // set when the player is hit during a step; not part of the state
+    bool m_playerHit = false;
+
+  public:
+    // A player command. Commands are queued and applied at the start of the
+    // next step, so a recording can say exactly which tick each one hit.
+    struct PlayerAction
+    {
+        enum class Kind : std::uint8_t
+        {
+            Input,
+            Shot,
+            Special
+        };
+
+        Kind kind = Kind::Input;
+        std::uint8_t input = 0;
+        Vec2<float> target;
+    };
+
+    // The right-click weapons. A Special action carries one in its input.
+    enum class SpecialWeapon : std::uint8_t
+    {
+        Laser,
+        Shockwave,
+        Count
+    };
+
+    static const char *specialWeaponName(SpecialWeapon weapon);
+
+    // CInput as bits, the form PlayerAction and replays carry it in
+    static constexpr std::uint8_t INPUT_UP = 1;
+    static constexpr std::uint8_t INPUT_DOWN = 2;
+    static constexpr std::uint8_t INPUT_LEFT = 4;
+    static constexpr std::uint8_t INPUT_RIGHT = 8;
+
+  private:
+    std::vector<PlayerAction> m_actions;
+
+    void applyActions();
+
+  public:
+    enum class System
+    {
+        Update,
+        Spawner,
+        Movement,
+        Lifespan,
+        Collision,
+        Particles,
+        Count
+    };
+
+    static const char *systemName(System system);
+
+    struct SystemToggles
+    {
+        bool spawner = true;
+        bool movement = true;
+        bool lifespan = true;
+        bool collision = true;
+        bool particles = true;
+    };
+
+    World() = default;
+
+    void init(const GameConfig &config);
+
+    // Applies queued player actions and pending adds/removes, runs every
+    // enabled system once and advances the frame counter. Each stage is passed to wrap(system, fn),
+    // which must call fn(); benchmarks and profilers hook in there.
+    template <typename Wrap>
+    void step(float dt, Wrap &&wrap)
+    {
+        m_playerHit = false;
+        applyActions();
+        wrap(System::Update, [&] { m_entities.update(); });
+
+        if (systems.spawner) wrap(System::Spawner, [&] { sEnemySpawner(); });
+        if (systems.movement) wrap(System::Movement, [&] { sMovement(dt); });
+        if (systems.lifespan) wrap(System::Lifespan, [&] { sLifespan(); });
+        if (systems.collision) wrap(System::Collision, [&] { sCollision(); });
+        if (systems.particles) wrap(System::Particles, [&] { sParticles(dt); });
+
+        m_currentFrame++;
+    }
+
+    void step(float dt)
+    {
+        step(dt, [](System, auto &&fn) { fn(); });
+    }
+
+    void sMovement(float dt);
+    void steerChasers(float dt);
+    void sLifespan();
+    void sEnemySpawner();
+    void sCollision();
+    void sParticles(float dt);
+
+    void spawnPlayer();
+    void spawnEnemy();
+    void spawnSmallEnemies(Entity *entity);
+    void spawnBullet(Entity *entity, const Vec2<float> &mousePos);
+    void spawnSpecialWeapon(Entity *entity, const Vec2<float> &target, SpecialWeapon weapon);
+    void fireLaser(Entity *entity, const Vec2<float> &target);
+    void fireShockwave(Entity *entity);
+    CollisionQuery &enemyQuery();
+    bool isColliding(Entity *a, Entity *b);
+    void respawnPlayer(Entity *player);
+    void emitExplosion(Entity *entity, size_t count);
+
+    Entity *player();
+
+    void queueInput(std::uint8_t input);
+    void queueShot(const Vec2<float> &target);
+    void queueSpecial(const Vec2<float> &target, SpecialWeapon weapon);
+
+    const std::vector<PlayerAction> &pendingActions() const
+    {
+        return m_actions;
+    }
+
+    // Full simulation state: entities (pending ones included), particles,
+    // random streams and counters. load() expects a World initialized from
+    // the same config and returns false on malformed data.
+    void save(ByteWriter &out) const;
+    bool load(ByteReader &in);
+
+    // The same state as save(), kept in memory as bulk copies so capture and
+    // restore take microseconds; see WorldSnapshotRing for the rewind buffer.
+    // A snapshot only restores into the World that captured it.
+    struct Snapshot
+    {
+        EntityManager::Snapshot entities;
+        ParticleSystem::Snapshot particles;
+        std::vector<PlayerAction> actions;
+        Rng spawnRng;
+        Rng splitRng;
+        int score = 0;
+        int currentFrame = 0;
+        int lastEnemySpawnTime = 0;
+
+        void reserve(size_t entityCount, size_t particleCount)
+        {
+            entities.reserve(entityCount);
+            particles.reserve(particleCount);
+        }
+
+        size_t bytes() const
+        {
+            return entities.bytes() + particles.bytes() + actions.capacity() * sizeof(PlayerAction);
+        }
+    };
+
+    void capture(Snapshot &s) const;
+    void restore(const Snapshot &s);
+
+    SystemToggles systems;
+
+    EntityManager &entities()
+    {
+        return m_entities;
+    }
+
+    const EntityManager &entities() const
+    {
+        return m_entities;
+    }
+
+    ParticleSystem &particles()
+    {
+        return m_particles;
+    }
+
+    const FlowField &flowField() const
+    {
+        return m_flow;
+    }
+
+    const ContactSolver &contacts() const
+    {
+        return m_contacts;
+    }
+
+    // Workers for the systems that can split their work; the world steps on
+    // the calling thread without one.
+    void setThreadPool(ThreadPool *pool)
+    {
+        m_pool = pool;
+    }
+
+    const Vec2<float> &bounds() const
+    {
+        return m_bounds;
+    }
+
+    int currentFrame() const
+    {
+        return m_currentFrame;
+    }
+
+    std::uint64_t seed() const
+    {
+        return m_seed;
+    }
+
+    // whether the player was hit and respawned during the last step
+    bool playerHit() const
+    {
+        return m_playerHit;
+    }
+
+    // Hash of the simulation state: every entity's components in iteration
+    // order, the frame counters and the random streams. Two runs from the
+    // same seed and input match tick for tick until they diverge. Particles
+    // only contribute their count, since their motion goes through libm.
+    std::uint64_t hash() const;
+};
@@ -0,0 +1,120 @@
+#include "WorldBatch.h"
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+void WorldBatch::init(const GameConfig &config, size_t count, size_t threads, int maxTicks)
+{
+    m_pool.reset();
+    m_config = config;
+    // nobody looks at a batch world, and the game's particle budget would
+    // otherwise be most of each one's memory
+    m_config.particles.MAX = 0;
+    m_maxTicks = maxTicks;
+    m_dt = 1.f / static_cast<float>(config.window.FPS);
+    m_seed = config.seed.VALUE;
+    if (m_seed == 0)
+    {
+        std::random_device rd;
+        m_seed = (static_cast<std::uint64_t>(rd()) << 32) | rd();
+    }
+
+    m_slots = std::vector<Slot>(count);
+    m_rewards.assign(count, 0.f);
+    m_done.assign(count, 0);
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    m_pool = std::make_unique<ThreadPool>(std::min(threads, std::max<size_t>(count, 1)));
+
+    m_nearest.clear();
+
+    // the worlds are built on their workers
+    forEachWorld([&](size_t, size_t i) { startEpisode(i); });
+}
+
+void WorldBatch::startEpisode(size_t index)
+{
+    Slot &slot = m_slots[index];
+    if (!slot.reset) return;
+
+    // a world has no reset of its own, so each episode gets a fresh one
+    GameConfig config = m_config;
+    Rng rng(m_seed ^ (static_cast<std::uint64_t>(index) << 32 | slot.episode));
+    config.seed.VALUE = rng.next() | 1;
+    slot.world.reset();
+    slot.world = std::make_unique<World>();
+    slot.world->init(config);
+    slot.world->systems.particles = false;
+
+    slot.score = 0;
+    slot.ticks = 0;
+    slot.input = 0;
+    slot.episode++;
+    slot.reset = false;
+}
+
+void WorldBatch::stepWorld(size_t index, const Action &action)
+{
+    startEpisode(index);
+
+    Slot &slot = m_slots[index];
+    World &world = *slot.world;
+    if (action.input != slot.input)
+    {
+        world.queueInput(action.input);
+        slot.input = action.input;
+    }
+    if (action.shoot)
+    {
+        world.queueShot(action.target);
+    }
+
+    world.step(m_dt);
+    slot.ticks++;
+
+    const int score = world.player()->get<CScore>().score;
+    m_rewards[index] = static_cast<float>(score - slot.score);
+    slot.score = score;
+    slot.reset = world.playerHit() || (m_maxTicks > 0 && slot.ticks >= m_maxTicks);
+    m_done[index] = slot.reset;
+}
+
+WorldBatch::StepResult WorldBatch::step(std::span<const Action> actions)
+{
+    if (actions.size() < m_slots.size())
+    {
+        std::cerr << "Error: WorldBatch::step needs " << m_slots.size() << " actions, got " << actions.size() << "\n";
+        return {};
+    }
+
+    forEachWorld([&](size_t, size_t i) { stepWorld(i, actions[i]); });
+    return {m_rewards, m_done};
+}
+
+void WorldBatch::observe(const ObservationGrid &grid, std::span<float> out)
+{
+    const size_t size = grid.size();
+    if (out.size() < m_slots.size() * size)
+    {
+        std::cerr << "Error: WorldBatch::observe needs " << m_slots.size() * size << " floats, got " << out.size()
+                  << "\n";
+        return;
+    }
+    forEachWorld([&](size_t, size_t i) { grid.write(*m_slots[i].world, out.subspan(i * size, size)); });
+}
+
+void WorldBatch::observeNearest(size_t count, std::span<float> out)
+{
+    const size_t size = count * ObservationNearest::FEATURES;
+    if (out.size() < m_slots.size() * size)
+    {
+        std::cerr << "Error: WorldBatch::observeNearest needs " << m_slots.size() * size << " floats, got "
+                  << out.size() << "\n";
+        return;
+    }
+    if (m_nearest.empty() || m_nearest.front().count() != count)
+    {
+        m_nearest.assign(m_pool->size(), ObservationNearest(count));
+    }
+    forEachWorld([&](size_t worker, size_t i) { m_nearest[worker].write(*m_slots[i].world, out.subspan(i * size, size)); });
+}
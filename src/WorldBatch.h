@@ -0,0 +1,121 @@
+#pragma once
+
+#include "Config.h"
+#include "Observation.h"
+#include "ThreadPool.hpp"
+#include "Vec2.hpp"
+#include "World.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Many independent headless worlds stepped together, for balancing runs and
+// training. step() applies one action per world, advances every world one
+// fixed tick across the thread pool and reports what each episode earned.
+//
+// Each world belongs to one worker for its whole life: that worker creates,
+// steps and resets it, so its memory comes from the worker's own allocator
+// arena, is first touched on the worker's core and is never handed between
+// threads.
+class WorldBatch
+{
+  public:
+    struct Action
+    {
+        // World::INPUT_* bits
+        std::uint8_t input = 0;
+        bool shoot = false;
+        Vec2<float> target;
+    };
+
+    struct StepResult
+    {
+        // score gained this tick
+        std::span<const float> rewards;
+        // the episode ended this tick: the player was hit or it reached
+        // maxTicks. The world starts a new episode on the next step.
+        std::span<const std::uint8_t> done;
+    };
+
+  private:
+    // padded so neighbouring workers never write to the same cache line
+    struct alignas(64) Slot
+    {
+        std::unique_ptr<World> world;
+        int score = 0;
+        int ticks = 0;
+        std::uint32_t episode = 0;
+        std::uint8_t input = 0;
+        bool reset = true;
+    };
+
+    GameConfig m_config;
+    std::vector<Slot> m_slots;
+    std::vector<float> m_rewards;
+    std::vector<std::uint8_t> m_done;
+    std::unique_ptr<ThreadPool> m_pool;
+    // one per worker, for its scratch space
+    std::vector<ObservationNearest> m_nearest;
+    std::uint64_t m_seed = 0;
+    int m_maxTicks = 0;
+    float m_dt = 0.f;
+
+    void startEpisode(size_t index);
+    void stepWorld(size_t index, const Action &action);
+
+    template <typename Fn>
+    void forEachWorld(Fn &&fn)
+    {
+        const std::function<void(size_t)> job = [&](size_t worker)
+        {
+            const size_t n = m_slots.size();
+            const size_t workers = m_pool->size();
+            for (size_t i = n * worker / workers; i < n * (worker + 1) / workers; i++)
+            {
+                fn(worker, i);
+            }
+        };
+        m_pool->run(job);
+    }
+
+  public:
+    // count worlds from config across threads workers (0 = one per hardware
+    // thread). Episodes last at most maxTicks (0 = until the player is hit).
+    // Episode e of world i is seeded from the config's seed, i and e, so a
+    // batch with a fixed seed replays exactly.
+    void init(const GameConfig &config, size_t count, size_t threads = 0, int maxTicks = 0);
+
+    // actions holds one entry per world.
+    StepResult step(std::span<const Action> actions);
+
+    size_t size() const
+    {
+        return m_slots.size();
+    }
+
+    size_t threads() const
+    {
+        return m_pool ? m_pool->size() : 0;
+    }
+
+    // Every world's grid into out, world i's at i * grid.size(), written on
+    // the workers straight into out. out must hold size() * grid.size().
+    void observe(const ObservationGrid &grid, std::span<float> out);
+
+    // Likewise for the count entities nearest each world's player; out must
+    // hold size() * count * ObservationNearest::FEATURES floats.
+    void observeNearest(size_t count, std::span<float> out);
+
+    // For reading between steps.
+    const World &world(size_t index) const
+    {
+        return *m_slots[index].world;
+    }
+
+    int episodeTicks(size_t index) const
+    {
+        return m_slots[index].ticks;
+    }
+};
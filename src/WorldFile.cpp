@@ -0,0 +1,372 @@
+#include "WorldFile.h"
+#include "Bytes.hpp"
+#include "Lz.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <tuple>
+#include <utility>
+
+namespace
+{
+using FourCC = std::array<char, 4>;
+
+constexpr FourCC MAGIC = {'A', 'G', 'W', 'D'};
+constexpr std::uint32_t VERSION = 1;
+
+constexpr FourCC WORLD_CHUNK = {'W', 'R', 'L', 'D'};
+constexpr FourCC TAGS_CHUNK = {'T', 'A', 'G', 'S'};
+constexpr FourCC ENTITIES_CHUNK = {'E', 'N', 'T', 'S'};
+constexpr FourCC PARTICLES_CHUNK = {'P', 'A', 'R', 'T'};
+
+// in ComponentTuple order
+constexpr std::array<FourCC, 6> COMPONENT_CHUNKS = {{
+    {'C', 'T', 'R', 'N'},
+    {'C', 'S', 'H', 'P'},
+    {'C', 'C', 'O', 'L'},
+    {'C', 'I', 'N', 'P'},
+    {'C', 'S', 'C', 'R'},
+    {'C', 'L', 'I', 'F'},
+}};
+constexpr size_t COMPONENTS = std::tuple_size_v<ComponentTuple>;
+// the most an LZ block can expand: one byte per 255 of a run length
+constexpr std::uint64_t MAX_LZ_RATIO = 255;
+static_assert(COMPONENT_CHUNKS.size() == COMPONENTS, "every component needs a chunk id");
+static_assert(COMPONENTS <= 8, "the component mask is one byte");
+
+enum Codec : std::uint8_t
+{
+    CodecRaw = 0,
+    CodecLz = 1
+};
+
+class ChunkWriter
+{
+    std::vector<std::uint8_t> &m_out;
+    std::vector<std::uint8_t> m_packed;
+    bool m_compress;
+
+  public:
+    std::uint32_t count = 0;
+
+    ChunkWriter(std::vector<std::uint8_t> &out, bool compress)
+        : m_out(out), m_compress(compress) {}
+
+    void put(const FourCC &id, const std::vector<std::uint8_t> &payload)
+    {
+        const std::vector<std::uint8_t> *stored = &payload;
+        Codec codec = CodecRaw;
+        if (m_compress)
+        {
+            m_packed.clear();
+            lzCompress(payload.data(), payload.size(), m_packed);
+            if (m_packed.size() < payload.size())
+            {
+                stored = &m_packed;
+                codec = CodecLz;
+            }
+        }
+
+        ByteWriter out(m_out);
+        out.put(id);
+        out.put(codec);
+        out.put(static_cast<std::uint64_t>(payload.size()));
+        out.put(static_cast<std::uint64_t>(stored->size()));
+        out.putBytes(stored->data(), stored->size());
+        count++;
+    }
+};
+
+struct Chunk
+{
+    FourCC id;
+    const std::uint8_t *data;
+    size_t size;
+};
+
+template <size_t I>
+void writeColumn(ChunkWriter &chunks, std::vector<std::uint8_t> &payload, const EntityVec &all)
+{
+    using T = std::tuple_element_t<I, ComponentTuple>;
+    payload.clear();
+    ByteWriter out(payload);
+    for (Entity *e : all)
+    {
+        if (e->has<T>()) out.put(e->get<T>());
+    }
+    chunks.put(COMPONENT_CHUNKS[I], payload);
+}
+
+template <size_t I>
+bool readColumn(const Chunk *chunk, const EntityVec &all, const std::vector<std::uint8_t> &mask)
+{
+    using T = std::tuple_element_t<I, ComponentTuple>;
+    if (!chunk) return true;
+
+    ByteReader in(chunk->data, chunk->size);
+    for (size_t i = 0; i < all.size(); i++)
+    {
+        if (!(mask[i] & (1u << I))) continue;
+
+        auto &c = all[i]->get<T>();
+        if (!in.get(c)) return false;
+        c.exists = true;
+    }
+    return true;
+}
+}
+
+void WorldFile::write(std::vector<std::uint8_t> &out, const World &world, bool compress)
+{
+    const EntityManager &em = world.m_entities;
+    EntityVec all = em.getEntities();
+    all.insert(all.end(), em.getPendingEntities().begin(), em.getPendingEntities().end());
+
+    ByteWriter header(out);
+    const size_t start = out.size();
+    header.put(MAGIC);
+    header.put(VERSION);
+    header.put(std::uint32_t{0});
+
+    ChunkWriter chunks(out, compress);
+    std::vector<std::uint8_t> payload;
+    ByteWriter w(payload);
+
+    w.put(static_cast<std::int32_t>(world.m_score));
+    w.put(static_cast<std::int32_t>(world.m_currentFrame));
+    w.put(static_cast<std::int32_t>(world.m_lastEnemySpawnTime));
+    w.put(world.m_seed);
+    w.put(world.m_spawnRng.state());
+    w.put(world.m_splitRng.state());
+    chunks.put(WORLD_CHUNK, payload);
+
+    // tags are interned, so the string's address identifies it
+    std::vector<const std::string *> tags;
+    std::vector<std::uint16_t> tagIndex(all.size());
+    for (size_t i = 0; i < all.size(); i++)
+    {
+        const std::string *tag = &all[i]->tag();
+        auto it = std::find(tags.begin(), tags.end(), tag);
+        tagIndex[i] = static_cast<std::uint16_t>(it - tags.begin());
+        if (it == tags.end()) tags.push_back(tag);
+    }
+    payload.clear();
+    w.putVarint(tags.size());
+    for (const std::string *tag : tags)
+    {
+        w.putString(*tag);
+    }
+    chunks.put(TAGS_CHUNK, payload);
+
+    payload.clear();
+    payload.reserve(all.size() * 12 + 24);
+    w.put(static_cast<std::uint64_t>(em.totalEntities()));
+    w.put(static_cast<std::uint64_t>(all.size()));
+    w.put(static_cast<std::uint64_t>(em.getEntities().size()));
+    for (Entity *e : all) w.put(static_cast<std::uint64_t>(e->id()));
+    w.putBytes(tagIndex.data(), tagIndex.size() * sizeof(std::uint16_t));
+    for (Entity *e : all) w.put(static_cast<std::uint8_t>(e->isAlive()));
+    for (Entity *e : all)
+    {
+        auto mask = [e]<size_t... I>(std::index_sequence<I...>)
+        {
+            return static_cast<std::uint8_t>(((e->has<std::tuple_element_t<I, ComponentTuple>>() << I) | ...));
+        }(std::make_index_sequence<COMPONENTS>());
+        w.put(mask);
+    }
+    chunks.put(ENTITIES_CHUNK, payload);
+
+    [&]<size_t... I>(std::index_sequence<I...>)
+    {
+        (writeColumn<I>(chunks, payload, all), ...);
+    }(std::make_index_sequence<COMPONENTS>());
+
+    payload.clear();
+    world.m_particles.save(w);
+    chunks.put(PARTICLES_CHUNK, payload);
+
+    std::memcpy(out.data() + start + sizeof(MAGIC) + sizeof(VERSION), &chunks.count, sizeof(chunks.count));
+}
+
+bool WorldFile::save(const std::string &path, const World &world, bool compress)
+{
+    std::vector<std::uint8_t> out;
+    write(out, world, compress);
+
+    std::FILE *file = std::fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        std::cerr << "Error: Could not open world file " << path << "\n";
+        return false;
+    }
+    bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    ok = std::fclose(file) == 0 && ok;
+    if (!ok)
+    {
+        std::cerr << "Error: Could not write world file " << path << "\n";
+    }
+    return ok;
+}
+
+bool WorldFile::load(const std::string &path, World &world)
+{
+    MappedFile file;
+    if (!file.open(path)) return false;
+    return read(file.data(), file.size(), world);
+}
+
+bool WorldFile::read(const std::uint8_t *data, size_t size, World &world)
+{
+    EntityManager &em = world.m_entities;
+    auto fail = [&](const char *why)
+    {
+        em.assign(0, {}, {}, {}, {}, 0);
+        world.m_particles.clear();
+        std::cerr << "Error: World file: " << why << "\n";
+        return false;
+    };
+
+    ByteReader in(data, size);
+    FourCC magic{};
+    std::uint32_t version = 0;
+    std::uint32_t count = 0;
+    if (!in.get(magic) || !in.get(version) || !in.get(count) || magic != MAGIC) return fail("not a world file");
+    if (version != VERSION) return fail("unsupported version");
+
+    // compressed chunks are unpacked up front; raw ones are read in place
+    std::vector<Chunk> chunks;
+    std::vector<std::vector<std::uint8_t>> unpacked;
+    for (std::uint32_t i = 0; i < count; i++)
+    {
+        Chunk c{};
+        std::uint8_t codec = 0;
+        std::uint64_t rawSize = 0;
+        std::uint64_t storedSize = 0;
+        if (!in.get(c.id) || !in.get(codec) || !in.get(rawSize) || !in.get(storedSize)) return fail("truncated");
+        const std::uint8_t *stored = in.skip(static_cast<size_t>(storedSize));
+        if (!stored) return fail("truncated");
+
+        if (codec == CodecRaw)
+        {
+            if (rawSize != storedSize) return fail("corrupt chunk");
+            c.data = stored;
+        }
+        else if (codec == CodecLz)
+        {
+            // check before allocating what the file claims
+            if (rawSize / MAX_LZ_RATIO > storedSize) return fail("corrupt compressed chunk");
+            auto &buffer = unpacked.emplace_back(static_cast<size_t>(rawSize));
+            if (!lzDecompress(stored, static_cast<size_t>(storedSize), buffer.data(), buffer.size()))
+            {
+                return fail("corrupt compressed chunk");
+            }
+            c.data = buffer.data();
+        }
+        else
+        {
+            return fail("unknown codec");
+        }
+        c.size = static_cast<size_t>(rawSize);
+        chunks.push_back(c);
+    }
+
+    auto find = [&](const FourCC &id) -> const Chunk *
+    {
+        for (const auto &c : chunks)
+        {
+            if (c.id == id) return &c;
+        }
+        return nullptr;
+    };
+
+    const Chunk *worldChunk = find(WORLD_CHUNK);
+    const Chunk *tagsChunk = find(TAGS_CHUNK);
+    const Chunk *entitiesChunk = find(ENTITIES_CHUNK);
+    if (!worldChunk || !tagsChunk || !entitiesChunk) return fail("missing chunk");
+
+    ByteReader w(worldChunk->data, worldChunk->size);
+    std::int32_t score = 0;
+    std::int32_t frame = 0;
+    std::int32_t lastSpawn = 0;
+    std::uint64_t seed = 0;
+    std::array<std::uint64_t, 4> spawnState;
+    std::array<std::uint64_t, 4> splitState;
+    if (!w.get(score) || !w.get(frame) || !w.get(lastSpawn) || !w.get(seed) || !w.get(spawnState) ||
+        !w.get(splitState))
+    {
+        return fail("truncated world chunk");
+    }
+
+    ByteReader t(tagsChunk->data, tagsChunk->size);
+    std::uint64_t tagCount = 0;
+    if (!t.getVarint(tagCount) || tagCount > t.remaining()) return fail("truncated tag table");
+    std::vector<std::string> tags(static_cast<size_t>(tagCount));
+    for (auto &tag : tags)
+    {
+        if (!t.getString(tag)) return fail("truncated tag table");
+    }
+
+    ByteReader e(entitiesChunk->data, entitiesChunk->size);
+    std::uint64_t total = 0;
+    std::uint64_t entityCount = 0;
+    std::uint64_t live = 0;
+    if (!e.get(total) || !e.get(entityCount) || !e.get(live) || live > entityCount ||
+        entityCount > e.remaining() / 12)
+    {
+        return fail("corrupt entity table");
+    }
+    const size_t n = static_cast<size_t>(entityCount);
+    std::vector<std::uint64_t> ids(n);
+    std::vector<std::uint16_t> tagIndex(n);
+    std::vector<std::uint8_t> alive(n);
+    std::vector<std::uint8_t> mask(n);
+    if (!e.getBytes(ids.data(), n * sizeof(std::uint64_t)) ||
+        !e.getBytes(tagIndex.data(), n * sizeof(std::uint16_t)) || !e.getBytes(alive.data(), n) ||
+        !e.getBytes(mask.data(), n))
+    {
+        return fail("truncated entity table");
+    }
+    for (std::uint16_t tag : tagIndex)
+    {
+        if (tag >= tags.size()) return fail("corrupt entity table");
+    }
+    // ids are handed out below total, and the next one would repeat them
+    for (std::uint64_t id : ids)
+    {
+        if (id >= total) return fail("corrupt entity table");
+    }
+
+    em.assign(static_cast<size_t>(total), tags, ids, tagIndex, alive, static_cast<size_t>(live));
+    EntityVec all = em.getEntities();
+    all.insert(all.end(), em.getPendingEntities().begin(), em.getPendingEntities().end());
+
+    bool columnsOk = [&]<size_t... I>(std::index_sequence<I...>)
+    {
+        return (readColumn<I>(find(COMPONENT_CHUNKS[I]), all, mask) && ...);
+    }(std::make_index_sequence<COMPONENTS>());
+    if (!columnsOk) return fail("truncated component column");
+    if (em.getEntities("player").empty()) return fail("no player");
+
+    if (const Chunk *particles = find(PARTICLES_CHUNK))
+    {
+        ByteReader p(particles->data, particles->size);
+        if (!world.m_particles.load(p)) return fail("corrupt particle chunk");
+    }
+    else
+    {
+        world.m_particles.clear();
+    }
+
+    world.m_score = score;
+    world.m_currentFrame = frame;
+    world.m_lastEnemySpawnTime = lastSpawn;
+    world.m_seed = seed;
+    world.m_spawnRng.setState(spawnState);
+    world.m_splitRng.setState(splitState);
+    world.m_actions.clear();
+    return true;
+}
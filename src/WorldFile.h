@@ -0,0 +1,43 @@
+#pragma once
+
+// Whole-world dumps, so benchmarks and bug repros can start from a saved
+// world instead of simulating their way to it. Loading maps the file and
+// fills entity storage a column at a time through EntityManager::assign.
+//
+// File layout (little-endian):
+//   header  "AGWD", u32 version, u32 chunk count
+//   chunk   fourcc, u8 codec (0 raw, 1 LZ, see Lz.h), u64 raw size,
+//           u64 stored size, payload
+//
+// Chunks:
+//   WRLD  i32 score, i32 frame, i32 last spawn frame, u64 seed, spawn and
+//         split random streams
+//   TAGS  varint count, strings
+//   ENTS  u64 ids handed out, u64 count, u64 live (the rest are pending
+//         adds), then the columns u64 id[], u16 tag[], u8 alive[],
+//         u8 component mask[] (bit i for ComponentTuple element i)
+//   CTRN CSHP CCOL CINP CSCR CLIF
+//         every present component of that type, packed in entity order
+//   PART  ParticleSystem::save bytes
+//
+// Readers skip chunks they don't know, so new ones don't need a version bump.
+
+#include "World.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class WorldFile
+{
+  public:
+    // compress runs every chunk through the LZ codec and keeps whichever of
+    // the two forms is smaller.
+    static bool save(const std::string &path, const World &world, bool compress = true);
+    static void write(std::vector<std::uint8_t> &out, const World &world, bool compress = true);
+
+    // The world must have been initialized from the config the dump was made
+    // with. On failure the reason is printed and the world is left empty.
+    static bool load(const std::string &path, World &world);
+    static bool read(const std::uint8_t *data, size_t size, World &world);
+};
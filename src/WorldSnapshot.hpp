@@ -0,0 +1,141 @@
+#pragma once
+
+#include "World.h"
+
+#include <algorithm>
+#include <vector>
+
+// A ring of World snapshots for rewinding and rollback. Every slot is
+// allocated and reserved up front, so capturing each tick is a handful of
+// bulk copies. Snapshots are addressed by how many captures back they are:
+// 0 is the newest.
+//
+// Each slot keeps the memory of the biggest world it has held, so a full
+// ring costs its slot count times the peak snapshot. With a byte budget, the
+// ring drops its oldest slots whenever the peak snapshot grows past what
+// the budget fits, keeping at least one.
+class WorldSnapshotRing
+{
+    std::vector<World::Snapshot> m_slots;
+    size_t m_next = 0;
+    size_t m_count = 0;
+    size_t m_budget = 0;
+    size_t m_peakBytes = 0;
+
+    World::Snapshot &at(size_t back)
+    {
+        return m_slots[(m_next + m_slots.size() - 1 - back) % m_slots.size()];
+    }
+
+    const World::Snapshot &at(size_t back) const
+    {
+        return m_slots[(m_next + m_slots.size() - 1 - back) % m_slots.size()];
+    }
+
+  public:
+    // Drops every snapshot and sizes each slot for entityCount entities and
+    // particleCount particles; bigger worlds still work, the first capture of
+    // each slot just grows it. A nonzero budget caps the bytes the slots
+    // hold, reserved memory included. A capacity of 0 frees everything.
+    void reset(size_t capacity, size_t entityCount, size_t particleCount, size_t budget = 0)
+    {
+        m_slots.clear();
+        m_slots.shrink_to_fit();
+        m_budget = budget;
+        m_peakBytes = 0;
+        m_next = 0;
+        m_count = 0;
+        if (capacity == 0) return;
+
+        World::Snapshot probe;
+        probe.reserve(entityCount, particleCount);
+        if (budget > 0)
+        {
+            capacity = std::clamp<size_t>(budget / std::max<size_t>(probe.bytes(), 1), 1, capacity);
+        }
+        m_slots.resize(capacity);
+        for (auto &s : m_slots)
+        {
+            s.reserve(entityCount, particleCount);
+        }
+    }
+
+    // Overwrites the oldest snapshot once the ring is full.
+    void capture(const World &world)
+    {
+        if (m_slots.empty()) return;
+
+        World::Snapshot &slot = m_slots[m_next];
+        world.capture(slot);
+        m_next = (m_next + 1) % m_slots.size();
+        m_count = std::min(m_count + 1, m_slots.size());
+
+        m_peakBytes = std::max(m_peakBytes, slot.bytes());
+        if (m_budget > 0 && m_peakBytes * m_slots.size() > m_budget)
+        {
+            shrink(std::max<size_t>(m_budget / m_peakBytes, 1));
+        }
+    }
+
+    // Keeps the newest capacity snapshots and frees the rest.
+    void shrink(size_t capacity)
+    {
+        if (capacity >= m_slots.size()) return;
+
+        std::vector<World::Snapshot> kept(capacity);
+        const size_t n = std::min(m_count, capacity);
+        for (size_t back = 0; back < n; back++)
+        {
+            kept[n - 1 - back] = std::move(at(back));
+        }
+        m_slots = std::move(kept);
+        m_next = n % capacity;
+        m_count = n;
+    }
+
+    // Leaves the ring as it is, so restoring can be repeated, e.g. while
+    // scrubbing or when a rollback re-simulates from the same tick.
+    bool restore(World &world, size_t back) const
+    {
+        if (back >= m_count) return false;
+
+        world.restore(at(back));
+        return true;
+    }
+
+    // Forgets the newest n snapshots, for carrying on from an older one.
+    void discard(size_t n)
+    {
+        if (m_slots.empty()) return;
+
+        n = std::min(n, m_count);
+        m_next = (m_next + m_slots.size() - n) % m_slots.size();
+        m_count -= n;
+    }
+
+    int frame(size_t back) const
+    {
+        return at(back).currentFrame;
+    }
+
+    size_t size() const
+    {
+        return m_count;
+    }
+
+    size_t capacity() const
+    {
+        return m_slots.size();
+    }
+
+    // heap the slots hold, reserved memory included
+    size_t bytes() const
+    {
+        size_t total = 0;
+        for (const auto &s : m_slots)
+        {
+            total += s.bytes();
+        }
+        return total;
+    }
+};